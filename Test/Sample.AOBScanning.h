@@ -22,6 +22,35 @@ DEF_SAMPLE(AOBScanning)
     std::tcout << ts("Found at ") << offset << std::endl;
   }
 
+  // AOB scanning with a pre-compiled pattern (supported half-byte wildcards)
+
+  vu::Pattern pattern_half_bytes(ts("1? ?? 3? 77 ?4 ?? 55"));
+  assert(data.match(pattern_half_bytes));
+  assert(data.find(pattern_half_bytes) == 0x01);
+
+  offsets = vu::find_pattern(data, pattern_half_bytes, false);
+  assert(offsets.size() == 3);
+
+  // AOB scanning multiple patterns in a single pass
+
+  vu::PatternSet patterns;
+  patterns.add(pattern_half_bytes);
+  patterns.add(vu::Pattern(ts("77 77 77 11")));
+  patterns.compile();
+
+  vu::PatternSet::THits hits;
+  patterns.scan(data.get_ptr(), data.get_size(), hits);
+  for (auto& hit : hits)
+  {
+    std::tcout << ts("Found pattern #") << hit.first << ts(" at ") << hit.second << std::endl;
+  }
+
+  // AOB scanning a file chunk by chunk without loading the whole file into memory
+
+  auto file_offsets = vu::find_pattern_in_file(
+    vu::get_current_file_path(), vu::Pattern(ts("4D 5A ?? 00")), true);
+  assert(!file_offsets.empty() && file_offsets.front() == 0);
+
   // AOB scanning a process testing
 
   auto pids = vu::name_to_pid(ts("dll_load_test.exe")); // remember to run app x86 or x64
@@ -48,6 +77,93 @@ DEF_SAMPLE(AOBScanning)
     for (auto& e : addresses) std::cout << vu::format_A("%p", e) << std::endl;
   }
 
+  // Value scanning the current process then narrowing the candidates by the next scans
+
+  {
+    static volatile int value = 0x13579BDF;
+
+    Process process;
+    process.attach(GetCurrentProcessId());
+    assert(process.ready());
+
+    vu::ScanSession session(process, vu::scan_value_type::SVT_INT32);
+    session.first_scan(vu::scan_compare_type::SCT_EQUALS, int(value));
+
+    value += 1;
+    session.next_scan(vu::scan_compare_type::SCT_INCREASED);
+    session.next_scan(vu::scan_compare_type::SCT_UNCHANGED);
+
+    auto addresses = session.addresses();
+    assert(std::find(addresses.cbegin(), addresses.cend(), vu::ulongptr(&value)) != addresses.cend());
+    std::cout << "number of candidates " << session.count() << std::endl;
+  }
+
+  {
+    static volatile float value = 100.25f;
+
+    Process process;
+    process.attach(GetCurrentProcessId());
+    assert(process.ready());
+
+    vu::ScanSession session(process, vu::scan_value_type::SVT_FLOAT, true, 0.01);
+    session.first_scan(vu::scan_compare_type::SCT_BETWEEN, 100, 101);
+
+    value -= 50.f;
+    session.next_scan(vu::scan_compare_type::SCT_DECREASED);
+    session.next_scan(vu::scan_compare_type::SCT_EQUALS, 50.25f);
+
+    auto addresses = session.addresses();
+    assert(std::find(addresses.cbegin(), addresses.cend(), vu::ulongptr(&value)) != addresses.cend());
+    std::cout << "number of candidates " << session.count() << std::endl;
+  }
+
+  {
+    // the unaligned value that crosses the boundary of two pages
+
+    auto ptr = static_cast<vu::byte*>(VirtualAlloc(nullptr, 2 * 0x1000, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    assert(ptr != nullptr);
+
+    int value = 0x2468ACE1;
+    memcpy(ptr + 0xFFE, &value, sizeof(value));
+
+    Process process;
+    process.attach(GetCurrentProcessId());
+    assert(process.ready());
+
+    vu::ScanSession session(process, vu::scan_value_type::SVT_INT32, false);
+    session.first_scan(vu::scan_compare_type::SCT_EQUALS, value);
+
+    value += 1;
+    memcpy(ptr + 0xFFE, &value, sizeof(value));
+    session.next_scan(vu::scan_compare_type::SCT_INCREASED);
+
+    auto addresses = session.addresses();
+    assert(std::find(addresses.cbegin(), addresses.cend(), vu::ulongptr(ptr + 0xFFE)) != addresses.cend());
+    std::cout << "number of candidates " << session.count() << std::endl;
+
+    VirtualFree(ptr, 0, MEM_RELEASE);
+  }
+
+  // Pointer scanning the static paths to an address of the current process
+
+  {
+    static int* volatile pointer = new int(0x2468ACE0);
+
+    Process process;
+    process.attach(GetCurrentProcessId());
+    assert(process.ready());
+
+    vu::PointerScanner scanner(process);
+
+    vu::PointerScanner::TPaths paths;
+    scanner.scan(paths, vu::ulongptr(pointer), 1, 0);
+    assert(!paths.empty()); // the static variable itself, the path is [module + offset] + 0
+
+    std::cout << "number of pointer paths " << paths.size() << std::endl;
+
+    delete pointer;
+  }
+
   // Testing read/write multi-level pointers
   // C:\Program Files\Cheat Engine 7.4\Tutorial-x86_64.exe
   // Eg. [[[[["Tutorial-x86_64.exe" + 0x325B00] + 0x10] + 0x18] + 0x0] + 0x18]
@@ -78,6 +194,27 @@ DEF_SAMPLE(AOBScanning)
     vu::write_memory_ex(
       arch::x64, process.handle(), address, &value, sizeof(value), false, 4, 0x10, 0x18, 0x0, 0x18);
     std::cout << value << std::endl;
+
+    // read many pointer chains at once, the shared levels are read once and cached for 1 second
+
+    vu::BatchReader reader(arch::x64, process.handle(), 1000);
+
+    vu::BatchReader::TChains chains(2);
+    chains[0].address = vu::ulongptr(address);
+    chains[0].offsets = { 0x10, 0x18, 0x0, 0x18 };
+    chains[1].address = vu::ulongptr(address);
+    chains[1].offsets = { 0x10, 0x18, 0x0, 0x1C };
+
+    int values[2] = { 0 };
+
+    vu::BatchReader::TRequests requests(2);
+    requests[0].buffer = &values[0];
+    requests[0].size = sizeof(values[0]);
+    requests[1].buffer = &values[1];
+    requests[1].size = sizeof(values[1]);
+
+    reader.read(requests, chains);
+    std::cout << values[0] << " " << values[1] << std::endl;
   }
   #endif
 
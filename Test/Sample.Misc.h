@@ -10,6 +10,13 @@ DEF_SAMPLE(Misc)
   // vu::msg_box(vu::get_console_window(), ts("I'm %s. I'm %d years old."), ts("Vic P"), 26);
   // vu::msg_debug(ts("I'm %s. I'm %d years old."), ts("Vic P"), 26);
 
+  #if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || (__cplusplus >= 201703L))
+  std::tcout << vu::fmt(VU_FMT(ts("I'm {}. I'm {} years old. (0x{:x})")), ts("Vic P"), 26, 26) << std::endl;
+  std::tstring text = ts("PI = ");
+  vu::fmt_to(text, ts("{:.5f}"), 3.14159265);
+  std::tcout << text << std::endl;
+  #endif
+
   std::tcout << vu::lower_string(ts("I Love You")) << std::endl;
   std::tcout << vu::upper_string(ts("I Love You")) << std::endl;
 
@@ -24,6 +31,10 @@ DEF_SAMPLE(Misc)
   for (auto e : l) std::tcout << e << ts("|");
   std::tcout << std::endl;
 
+  vu::Tokenizer tokenizer(ts("THIS IS\tA  TOKENIZED STRING"), ts(" \t"), true, vu::separator_type::ST_ANY_OF);
+  for (vu::StringView token; tokenizer.next(token);) std::tcout << token.to_string() << ts("|");
+  std::tcout << std::endl;
+
   l.clear();
   l = vu::multi_string_to_list(ts("THIS\0IS\0A\0MULTI\0STRING\0\0"));
   for (auto& e : l) std::tcout << e << ts("|");
@@ -93,9 +104,9 @@ DEF_SAMPLE(Misc)
   vu::FileSystem::iterate(ts("path\\to\\example"), ts("*.txt"), [](const vu::FSObject& fso) -> bool
   {
     auto file_path = fso.directory + fso.name;
-    auto data = vu::FileSystem::quick_read_as_buffer(file_path);
 
-    auto result = vu::determine_encoding_type(data.get_ptr(), data.get_size());
+    auto info = vu::detect_encoding_in_file(file_path); // Only the first 64 KiB are read
+    auto result = info.type;
     auto es = result == vu::encoding_type::ET_UNKNOWN ? L"Unknown" : LES[int(result)];
     auto el = result == vu::encoding_type::ET_UNKNOWN ? L"Unknown" : LEL[int(result)];
 
@@ -105,6 +116,8 @@ DEF_SAMPLE(Misc)
       << " | "
       << std::setw(25) << el
       << " | "
+      << std::setw(4) << int(info.confidence * 100) << "%"
+      << " | "
       << fso.name.c_str()
       << std::endl;
 
@@ -143,6 +156,16 @@ DEF_SAMPLE(Misc)
   }
   std::tcout << std::endl;
 
+  std::tcout << vu::to_hex_string(hex_bytes.data(), hex_bytes.size(), true, ts(' ')) << std::endl; // 00 11 .. FF
+
+  char hex_text[64]; // into a caller buffer, eg. the hashes of the logs
+  const auto hex_length = vu::to_hex_string_A(hex_bytes.data(), hex_bytes.size(), hex_text, sizeof(hex_text));
+  assert(hex_length == 2 * hex_bytes.size());
+
+  std::string hex_dump_text; // reused by the next dumps
+  vu::hex_dump(hex_bytes.data(), hex_bytes.size(), hex_dump_text);
+  std::cout << hex_dump_text;
+
   std::tstring url_encoded;
   vu::url_encode(ts("vic.onl/+1 2-3%4"), url_encoded);
   std::tcout << "URL Encoded : " << url_encoded << std::endl;
@@ -151,6 +174,14 @@ DEF_SAMPLE(Misc)
   vu::url_decode(ts("vic.onl%2f%2b1%202-3%254"), url_decoded);
   std::tcout << "URL Decoded : " << url_decoded << std::endl;
 
+  char query[] = "?name=Vic+P.&city=H%C3%A0+N%E1%BB%99i&debug";
+  std::vector<vu::QueryParamA> params; // reused by the next requests
+  vu::parse_query_string_A(query, strlen(query), params); // decoded in place
+  for (const auto& param : params)
+  {
+    std::cout << param.first.to_string() << " = " << param.second.to_string() << std::endl;
+  }
+
   std::string s = "0123456789";
   vu::Buffer  slicer(s.data(), s.size());
 
@@ -171,6 +202,43 @@ DEF_SAMPLE(Misc)
   std::cout << slicer(-9, 10).to_string_A() << std::endl;
   std::cout << slicer(-10, 10).to_string_A() << std::endl;
 
+  vu::Buffer appender; // the capacity grows geometrically, not on every appending
+  for (int i = 0; i < 1000; i++) appender.append(s.data(), s.size());
+  assert(appender.get_size() == 1000 * s.size() && appender.get_capacity() >= appender.get_size());
+
+  appender.shrink_to_fit();
+  assert(appender.get_capacity() == appender.get_size());
+
+  vu::BufferView viewer(slicer); // the slices of a view are not copied
+  assert(viewer(3, 7).get_ptr() == slicer.get_ptr_bytes() + 3);
+  assert(viewer(-7, -2).to_string_A() == slicer(-7, -2).to_string_A());
+  assert(viewer.till("5", 1).get_size() == 5);
+
+  vu::Buffer finder(s.data(), s.size());
+  finder.append(s.data(), s.size());
+  assert(finder.find("345", 3) == 3 && finder.rfind("345", 3) == 13);
+  assert(finder.count("9012", 4) == 1 && finder.find_all("0", 1).size() == 2);
+  assert(finder.till("abc", 3).empty()); // not found
+
+  vu::BufferPool pool; // the freed blocks are reused by the next buffers of the pool
+  for (int i = 0; i < 100; i++)
+  {
+    vu::Buffer pooled;
+    pooled.set_pool(&pool);
+    pooled.resize(KiB, false); // not zeroed, it will be overwritten
+    pooled.fill(0xFF);
+  }
+  auto pool_stats = pool.statistics();
+  assert(pool_stats.misses == 1 && pool_stats.hits == 99 && pool_stats.bytes_outstanding == 0);
+
+  vu::BufferChain chain; // the segments are written out by a single vectored write, never flattened
+  chain.append(vu::BufferView(s.data(), 10)); // not copied
+  chain.append(finder);                       // copied
+  chain.append(std::move(appender));          // moved
+  assert(chain.count() == 3 && chain.get_size() == 10 + finder.get_size() + 1000 * s.size());
+  chain.consume(15); // the first segment and the head of the second one
+  assert(chain.count() == 2 && chain.at(0).get_ptr_bytes()[0] == '5');
+
   std::tcout << vu::undecorate_cpp_symbol(ts("?func1@a@@AAEXH@Z")) << std::endl;
 
   #if defined(_MSC_VER) || defined(__BCPLUSPLUS__) // LNK
@@ -15,5 +15,116 @@ DEF_SAMPLE(StopWatch)
   Sleep(500);
   logger.log(ts("Test 3 : "));
 
+  // Benchmark the small buffers (inline up to VU_BUFFER_INLINE_SIZE bytes) versus the heap ones
+
+  const int N = 1000000;
+  const char frame[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n"; // a short socket frame
+  vu::uint64 checksum = 0;
+
+  {
+    vu::ScopeStopWatch bench(ts("Small Frames ->"), vu::ScopeStopWatch::console);
+
+    for (int i = 0; i < N; i++) // the construction of a buffer per frame, without the socket
+    {
+      std::vector<vu::byte> received(sizeof(frame));
+      memcpy(received.data(), frame, sizeof(frame));
+      checksum += received[i % sizeof(frame)];
+    }
+    bench.log(ts("construct std::vector (heap) : "));
+
+    for (int i = 0; i < N; i++)
+    {
+      vu::Buffer received(sizeof(frame));
+      memcpy(received.get_ptr(), frame, sizeof(frame));
+      checksum += received[i % sizeof(frame)];
+    }
+    bench.log(ts("construct vu::Buffer (inline) : "));
+
+    for (int i = 0; i < N; i++) // the hashing path, a buffer per hashed header
+    {
+      std::vector<vu::byte> header(frame, frame + 16);
+      checksum += vu::crypt_crc_buffer(header, vu::crypt_bits::_32);
+    }
+    bench.log(ts("crc32 std::vector (heap) : "));
+
+    for (int i = 0; i < N; i++)
+    {
+      vu::Buffer header(frame, 16);
+      checksum += vu::crypt_crc_buffer(header, vu::crypt_bits::_32);
+    }
+    bench.log(ts("crc32 vu::Buffer (inline) : "));
+  }
+
+  #if defined(VU_INET_ENABLED)
+
+  // Benchmark the small frames received by Socket::recv over a loopback connection, a buffer per frame
+
+  vu::Socket listener;
+  vu::Socket client;
+  vu::Socket::Handle connection;
+
+  if (listener.bind("127.0.0.1", 0) == vu::VU_OK &&
+      listener.listen() == vu::VU_OK &&
+      client.connect("127.0.0.1", ntohs(listener.get_local_sai().sin_port)) == vu::VU_OK &&
+      listener.accept(connection) == vu::VU_OK)
+  {
+    vu::Socket server(AF_INET, SOCK_STREAM, IPPROTO_IP, false);
+    server.attach(connection);
+
+    const int M = 100000; // The number of the received frames
+    const int K = 64;     // The number of the frames per send, they fit in the loopback buffer
+    const int n = int(sizeof(frame) - 1);
+
+    std::string frames;
+    for (int i = 0; i < K; i++) frames.append(frame, n);
+
+    vu::ScopeStopWatch bench(ts("Loopback Frames ->"), vu::ScopeStopWatch::console);
+
+    bool ok = true;
+
+    for (int i = 0; ok && i < M; i += K)
+    {
+      ok = client.send(frames.data(), int(frames.size())) == int(frames.size());
+
+      for (int received_bytes = 0; ok && received_bytes < int(frames.size());)
+      {
+        std::vector<vu::byte> received(n);
+        const auto z = server.recv(reinterpret_cast<char*>(received.data()), n);
+        ok = z > 0;
+        received_bytes += ok ? z : 0;
+        checksum += received[0];
+      }
+    }
+    bench.log(ts("Socket::recv std::vector (heap) : "));
+
+    for (int i = 0; ok && i < M; i += K)
+    {
+      ok = client.send(frames.data(), int(frames.size())) == int(frames.size());
+
+      for (int received_bytes = 0; ok && received_bytes < int(frames.size());)
+      {
+        vu::Buffer received(n);
+        const auto z = server.recv(received);
+        ok = z > 0;
+        received_bytes += ok ? z : 0;
+        checksum += ok ? received[0] : 0;
+      }
+    }
+    bench.log(ts("Socket::recv vu::Buffer (inline) : "));
+
+    if (!ok)
+    {
+      std::tcout << ts("Loopback Frames -> Recv -> Failed") << std::endl;
+    }
+  }
+  else
+  {
+    std::tcout << ts("Loopback Frames -> Connect -> Failed") << std::endl;
+  }
+
+  #endif // VU_INET_ENABLED
+
+  std::cout << "checksum " << checksum << std::endl;
+
   return vu::VU_OK;
 }
@@ -81,6 +81,7 @@
 #endif // _WIN_SVC_
 
 #include <set>
+#include <deque>
 #include <cmath>
 #include <ctime>
 #include <mutex>
@@ -96,6 +97,17 @@
 #include <type_traits>
 #include <unordered_map>
 
+#if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || (__cplusplus >= 201703L))
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #endif // _MSC_VER
@@ -173,6 +185,8 @@ typedef BigInt BigNumber;
  */
 
 class Buffer;
+class BufferView;
+class Pattern;
 
 bool vuapi is_administrator();
 bool set_privilege_A(const std::string&  privilege, const bool enable);
@@ -189,6 +203,32 @@ std::vector<size_t> find_pattern_A(
   const void* ptr, const size_t size, const std::string& pattern, const bool first_match_only);
 std::vector<size_t> find_pattern_W(
   const void* ptr, const size_t size, const std::wstring& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_A(
+  const Buffer& buffer, const Pattern& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_W(
+  const Buffer& buffer, const Pattern& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_A(
+  const BufferView& view, const std::string&  pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_W(
+  const BufferView& view, const std::wstring& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_A(
+  const BufferView& view, const Pattern& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_W(
+  const BufferView& view, const Pattern& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_A(
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_W(
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only);
+std::vector<size_t> find_pattern_A(
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only,
+  const size_t n_threads);
+std::vector<size_t> find_pattern_W(
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only,
+  const size_t n_threads);
+std::vector<uint64> find_pattern_in_file_A(
+  const std::string& file_path, const Pattern& pattern, const bool first_match_only);
+std::vector<uint64> find_pattern_in_file_W(
+  const std::wstring& file_path, const Pattern& pattern, const bool first_match_only);
 
 #include "template/misc.tpl"
 
@@ -200,6 +240,7 @@ bool vuapi is_flag_on(ulongptr flags, ulongptr flag);
 intptr vuapi gcd(ulongptr count, ...); // UCLN
 intptr vuapi lcm(ulongptr count, ...); // BCNN
 void vuapi hex_dump(const void* data, int size);
+void vuapi hex_dump(const void* data, const size_t size, std::string& result); // The result is reused
 
 #include "template/math.tpl"
 
@@ -220,6 +261,17 @@ enum class encoding_type : int
   ET_UTF32_BE_BOM = 7, // "UTF-32 BE BOM", "UTF-32 Big Endian BOM"
 };
 
+#define VU_DEFAULT_ENCODING_SAMPLE_SIZE (64 * KiB) // The prefix of the data that the detection examines
+
+struct EncodingInfo
+{
+  encoding_type type;
+  float  confidence;  // From 0.0 (a guess) to 1.0 (certain, eg. a BOM)
+  size_t bom_size;    // The size of the BOM (0 if none)
+  size_t sample_size; // The number of the examined bytes
+  bool   valid_utf8;  // The examined bytes are well-formed UTF-8 (a sequence cut by the sample is ignored)
+};
+
 enum class data_unit_type : int
 {
   SI  = 1000, // 1 KB  = 1000 bytes
@@ -243,16 +295,35 @@ std::wstring vuapi format_date_time_W(const time_t t, const std::wstring format)
 std::string vuapi date_time_to_string_A(const time_t t);
 std::wstring vuapi date_time_to_string_W(const time_t t);
 encoding_type vuapi determine_encoding_type(const void* data, const size_t size);
+EncodingInfo vuapi detect_encoding( // Only the first `max_sample_size` bytes are examined, -1 to examine all
+  const void* data, const size_t size, const size_t max_sample_size = VU_DEFAULT_ENCODING_SAMPLE_SIZE);
+EncodingInfo vuapi detect_encoding_in_file_A( // Only the first `max_sample_size` bytes are read
+  const std::string& file_path, const size_t max_sample_size = VU_DEFAULT_ENCODING_SAMPLE_SIZE);
+EncodingInfo vuapi detect_encoding_in_file_W(
+  const std::wstring& file_path, const size_t max_sample_size = VU_DEFAULT_ENCODING_SAMPLE_SIZE);
 std::string vuapi format_bytes_A(long long bytes, data_unit_type dut = data_unit_type::IEC, int digits = 2);
 std::wstring vuapi format_bytes_W(long long bytes, data_unit_type dut = data_unit_type::IEC, int digits = 2);
-std::string vuapi to_hex_string_A(const byte* ptr, const size_t size);
-std::wstring vuapi to_hex_string_W(const byte* ptr, const size_t size);
+std::string vuapi to_hex_string_A(
+  const byte* ptr, const size_t size, const bool upper = false, const char separator = 0);
+std::wstring vuapi to_hex_string_W(
+  const byte* ptr, const size_t size, const bool upper = false, const wchar separator = 0);
+size_t vuapi to_hex_string_A( // The text is written if it fits, not null-terminated, returns the needed length
+  const byte* ptr, const size_t size, char* text, const size_t length,
+  const bool upper = false, const char separator = 0);
+size_t vuapi to_hex_string_W(
+  const byte* ptr, const size_t size, wchar* text, const size_t length,
+  const bool upper = false, const wchar separator = 0);
 bool vuapi to_hex_bytes_A(const std::string& text, std::vector<byte>& bytes);
 bool vuapi to_hex_bytes_W(const std::wstring& text, std::vector<byte>& bytes);
-void vuapi url_encode_A(const std::string& text, std::string& result);
-void vuapi url_encode_W(const std::wstring& text, std::wstring& result);
-void vuapi url_decode_A(const std::string& text, std::string& result);
-void vuapi url_decode_W(const std::wstring& text, std::wstring& result);
+bool vuapi to_hex_bytes_A(const char* text, const size_t length, byte* bytes, size_t& size); // [in,out] size
+bool vuapi to_hex_bytes_W(const wchar* text, const size_t length, byte* bytes, size_t& size); // [in,out] size
+void vuapi url_encode_A(const std::string& text, std::string& result, const bool form = false); // Form: ' ' as '+'
+void vuapi url_encode_W(const std::wstring& text, std::wstring& result, const bool form = false); // As UTF-8
+size_t vuapi url_encode_A( // The text is written if it fits, not null-terminated, returns the needed length
+  const char* text, const size_t length, char* buffer, const size_t size, const bool form = false);
+void vuapi url_decode_A(const std::string& text, std::string& result, const bool form = false); // Form: '+' as ' '
+void vuapi url_decode_W(const std::wstring& text, std::wstring& result, const bool form = false); // As UTF-8
+size_t vuapi url_decode_A(char* text, const size_t length, const bool form = false); // In place, returns the length
 
 /**
  * String Working
@@ -265,16 +336,133 @@ enum class trim_type
   TS_BOTH  = 2,
 };
 
+/**
+ * StringViewT
+ * The non-owning view of a string, the viewed string must outlive the view.
+ */
+
+template <typename T>
+class StringViewT
+{
+public:
+  typedef std::basic_string<T> TString;
+
+  static const size_t npos = size_t(-1);
+
+  StringViewT();
+  StringViewT(const T* ptr);
+  StringViewT(const T* ptr, const size_t size);
+  StringViewT(const TString& string);
+
+  bool operator==(const StringViewT& right) const;
+  bool operator!=(const StringViewT& right) const;
+  const T& operator[](const size_t index) const;
+
+  const T* data() const;
+  size_t size() const;
+  bool empty() const;
+
+  const T* begin() const;
+  const T* end() const;
+
+  size_t find(const T c, const size_t offset = 0) const;
+  size_t find(const StringViewT& string, const size_t offset = 0) const;
+  size_t find_first_of(const StringViewT& chars, const size_t offset = 0) const;
+  StringViewT substr(const size_t offset, const size_t count = npos) const;
+
+  TString to_string() const;
+
+private:
+  const T* m_ptr;
+  size_t m_size;
+};
+
+typedef StringViewT<char>  StringViewA;
+typedef StringViewT<wchar> StringViewW;
+
+/**
+ * TokenizerT
+ * The lazy tokenizer that yields the views of the tokens, nothing is copied or allocated.
+ */
+
+enum class separator_type
+{
+  ST_STRING = 0, // The whole separator, eg. "\r\n"
+  ST_ANY_OF = 1, // Any character of the separator, eg. " \t"
+};
+
+template <typename T>
+class TokenizerT
+{
+public:
+  typedef StringViewT<T> TStringView;
+
+  TokenizerT(const TStringView& text, const T separator, const bool remove_empty = false);
+  TokenizerT(
+    const TStringView& text,
+    const TStringView& separator,
+    const bool remove_empty = false,
+    const separator_type type = separator_type::ST_STRING);
+
+  bool next(TStringView& token);
+  void reset();
+
+private:
+  size_t find_separator(const size_t offset, size_t& length) const;
+
+private:
+  TStringView m_text;
+  TStringView m_separator;
+  T m_char;
+  bool m_single;
+  bool m_remove_empty;
+  bool m_done;
+  separator_type m_type;
+  size_t m_offset;
+  uint32 m_table[8]; // The bitmap of the ASCII/Latin-1 separators of ST_ANY_OF
+};
+
+typedef TokenizerT<char>  TokenizerA;
+typedef TokenizerT<wchar> TokenizerW;
+
 std::string vuapi lower_string_A(const std::string& string);
 std::wstring vuapi lower_string_W(const std::wstring& string);
 std::string vuapi upper_string_A(const std::string& string);
 std::wstring vuapi upper_string_W(const std::wstring& string);
 std::string vuapi to_string_A(const std::wstring& string);
 std::wstring vuapi to_string_W(const std::string& string);
+
+/**
+ * The validating transcoders of UTF-8, UTF-16LE and UTF-32.
+ * The text is written to the buffer if it fits, if the buffer is null only the needed size is predicted.
+ * @return The needed size of the buffer in its units, or -1 if the text is not well-formed.
+ */
+size_t vuapi utf8_to_utf16(const char* text, const size_t length, wchar* buffer, const size_t size);
+size_t vuapi utf16_to_utf8(const wchar* text, const size_t length, char* buffer, const size_t size);
+size_t vuapi utf8_to_utf32(const char* text, const size_t length, uint32* buffer, const size_t size);
+size_t vuapi utf32_to_utf8(const uint32* text, const size_t length, char* buffer, const size_t size);
+size_t vuapi utf16_to_utf32(const wchar* text, const size_t length, uint32* buffer, const size_t size);
+size_t vuapi utf32_to_utf16(const uint32* text, const size_t length, wchar* buffer, const size_t size);
+bool vuapi utf8_to_utf16(const std::string& text, std::wstring& result);
+bool vuapi utf16_to_utf8(const std::wstring& text, std::string& result);
+
 std::vector<std::string> vuapi split_string_A(
   const std::string& string, const std::string& separator, bool remove_empty = false);
 std::vector<std::wstring> vuapi split_string_W(
   const std::wstring& string, const std::wstring& separator, bool remove_empty = false);
+std::vector<StringViewA> vuapi split_string_view_A(
+  const StringViewA& string, const StringViewA& separator, bool remove_empty = false);
+std::vector<StringViewW> vuapi split_string_view_W(
+  const StringViewW& string, const StringViewW& separator, bool remove_empty = false);
+
+typedef std::pair<StringViewA, StringViewA> QueryParamA; // (key, value)
+typedef std::pair<StringViewW, StringViewW> QueryParamW;
+
+void vuapi parse_query_string_A( // The params are reused, the keys and the values are not decoded
+  const StringViewA& query, std::vector<QueryParamA>& params);
+void vuapi parse_query_string_W(const StringViewW& query, std::vector<QueryParamW>& params);
+void vuapi parse_query_string_A( // The keys and the values are decoded in place in the query (form)
+  char* query, const size_t length, std::vector<QueryParamA>& params);
 std::string vuapi join_string_A(const std::vector<std::string> parts, const std::string& separator = "");
 std::wstring vuapi join_string_W(const std::vector<std::wstring> parts, const std::wstring& separator = L"");
 std::vector<std::string> vuapi multi_string_to_list_A(const char* ps_multi_string);
@@ -314,6 +502,8 @@ std::wstring vuapi regex_replace_string_W(
   const std::wstring& replacement,
   std::regex_constants::match_flag_type flags = std::regex_constants::match_default);
 
+#include "template/fmt.tpl"
+
 /**
  * Process Working
  */
@@ -645,6 +835,8 @@ bool vuapi crypt_b64decode_W(const std::wstring& text, std::vector<byte>& data);
 
 std::string  vuapi crypt_md5_buffer_A(const std::vector<byte>& data);
 std::wstring vuapi crypt_md5_buffer_W(const std::vector<byte>& data);
+std::string  vuapi crypt_md5_buffer_A(const BufferView& data);
+std::wstring vuapi crypt_md5_buffer_W(const BufferView& data);
 std::string  vuapi crypt_md5_text_A(const std::string& text);
 std::wstring vuapi crypt_md5_text_W(const std::wstring& text);
 std::string  vuapi crypt_md5_file_A(const std::string& file_path);
@@ -677,10 +869,13 @@ uint64 vuapi crypt_crc_text_W(const std::wstring& text, const crypt_bits bits);
 uint64 vuapi crypt_crc_file_A(const std::string& file_path, const crypt_bits bits);
 uint64 vuapi crypt_crc_file_W(const std::wstring& file_path, const crypt_bits bits);
 uint64 vuapi crypt_crc_buffer(const std::vector<byte>& data, const crypt_bits bits);
+uint64 vuapi crypt_crc_buffer(const BufferView& data, const crypt_bits bits);
 
 // Note: For reduce library size so only enabled 32/64-bits of parametrized CRC algorithms
 uint64 vuapi crypt_crc_buffer(const std::vector<byte>& data,
   uint8_t bits, uint64 poly, uint64 init, bool ref_in, bool ref_out, uint64 xor_out, uint64 check);
+uint64 vuapi crypt_crc_buffer(const BufferView& data,
+  uint8_t bits, uint64 poly, uint64 init, bool ref_in, bool ref_out, uint64 xor_out, uint64 check);
 
 // SHA
 
@@ -704,6 +899,11 @@ void vuapi crypt_sha_buffer(
   const sha_version version,
   const crypt_bits bits,
   std::vector<byte>& hash);
+void vuapi crypt_sha_buffer(
+  const BufferView& data,
+  const sha_version version,
+  const crypt_bits bits,
+  std::vector<byte>& hash);
 
 /*----------- The definition of common function(s) which compatible both ANSI & UNICODE ----------*/
 
@@ -713,12 +913,14 @@ void vuapi crypt_sha_buffer(
 #define get_env get_env_W
 #define set_env set_env_W
 #define find_pattern find_pattern_W
+#define find_pattern_in_file find_pattern_in_file_W
 /* String Formatting */
 #define format format_W
 #define msg_debug msg_debug_W
 #define msg_box msg_box_W
 #define get_last_error get_last_error_W
 #define date_time_to_string date_time_to_string_W
+#define detect_encoding_in_file detect_encoding_in_file_W
 #define format_date_time format_date_time_W
 #define format_bytes format_bytes_W
 #define to_hex_string to_hex_string_W
@@ -729,6 +931,8 @@ void vuapi crypt_sha_buffer(
 #define lower_string lower_string_W
 #define upper_string upper_string_W
 #define split_string split_string_W
+#define split_string_view split_string_view_W
+#define parse_query_string parse_query_string_W
 #define join_string join_string_W
 #define multi_string_to_list multi_string_to_list_W
 #define list_to_multi_string list_to_multi_string_W
@@ -785,12 +989,14 @@ void vuapi crypt_sha_buffer(
 #define get_env get_env_A
 #define set_env set_env_A
 #define find_pattern find_pattern_A
+#define find_pattern_in_file find_pattern_in_file_A
 /* String Formatting */
 #define format format_A
 #define msg_debug msg_debug_A
 #define msg_box msg_box_A
 #define get_last_error get_last_error_A
 #define date_time_to_string date_time_to_string_A
+#define detect_encoding_in_file detect_encoding_in_file_A
 #define format_date_time format_date_time_A
 #define format_bytes format_bytes_A
 #define to_hex_string to_hex_string_A
@@ -801,6 +1007,8 @@ void vuapi crypt_sha_buffer(
 #define lower_string lower_string_A
 #define upper_string upper_string_A
 #define split_string split_string_A
+#define split_string_view split_string_view_A
+#define parse_query_string parse_query_string_A
 #define join_string join_string_A
 #define multi_string_to_list multi_string_to_list_A
 #define load_rs_string load_rs_string_A
@@ -972,10 +1180,106 @@ public:
 
 #endif // VU_GUID_ENABLED
 
+/**
+ * Buffer Pool
+ * The size-classed cache of the memory blocks for the buffers those are bound to it, the freed blocks
+ * are kept for reusing instead of going back to the heap. The cache is split into the shards and each
+ * thread uses its own shard, so the threads rarely wait for each other. The maximum cached size is shared
+ * by all shards, so any shard can cache the largest class. The pool must outlive its buffers.
+ */
+
+class BufferPool
+{
+public:
+  struct Statistics
+  {
+    uint64 hits;              // The allocations those reused a cached block
+    uint64 misses;            // The allocations those went to the heap
+    uint64 bytes_outstanding; // The bytes of the blocks those are in use
+    uint64 bytes_cached;      // The bytes of the blocks those are cached for reusing
+  };
+
+  BufferPool(const size_t max_cached_size = 64 * MiB);
+  virtual ~BufferPool();
+
+  void* allocate(const size_t size, size_t& capacity);
+  void  deallocate(void* ptr, const size_t capacity);
+  void  trim();
+
+  Statistics statistics() const;
+
+private:
+  BufferPool(const BufferPool&);            // Not copyable
+  BufferPool& operator=(const BufferPool&); // Not copyable
+
+  struct Shard;
+  struct Total;
+  Shard& get_shard() const;
+
+private:
+  Shard* m_shards;
+  Total* m_total;
+  size_t m_n_shards;
+  size_t m_max_cached_size; // The maximum cached bytes of all shards together
+};
+
+/**
+ * Buffer View
+ * The non-owning read-only window (pointer + size) of a memory, the slicing and the searching of
+ * a view never allocate nor copy, so the memory must outlive the view.
+ */
+
+class BufferView
+{
+public:
+  BufferView();
+  BufferView(const void* ptr, const size_t size);
+  BufferView(const Buffer& buffer);
+  BufferView(const std::vector<byte>& data);
+
+  bool operator==(const BufferView& right) const;
+  bool operator!=(const BufferView& right) const;
+  const byte& operator[](const size_t offset) const;
+  BufferView operator()(intptr begin, intptr end) const;
+
+  const byte* get_ptr_bytes() const;
+  const void* get_ptr() const;
+  size_t get_size() const;
+
+  bool empty() const;
+
+  bool match(const void* ptr, const size_t size) const;
+  bool match(const Pattern& pattern) const;
+  size_t find(const void* ptr, const size_t size) const;
+  size_t find(const Pattern& pattern) const;
+  size_t rfind(const void* ptr, const size_t size) const;
+  std::vector<size_t> find_all(const void* ptr, const size_t size) const; // The overlapped ones included
+  size_t count(const void* ptr, const size_t size) const;
+  BufferView till(const void* ptr, const size_t size) const;
+  BufferView slice(intptr begin, intptr end) const; // The negative indices are from the end
+  bool read(const size_t offset, void* ptr, const size_t size) const;
+
+  std::string  to_string_A() const;
+  std::wstring to_string_W() const;
+
+private:
+  const byte* m_ptr;
+  size_t m_size;
+};
+
 /**
  * Buffer
+ * The size of the data is separated from the capacity of the memory, the capacity grows
+ * geometrically on appending so building a buffer by appending takes an amortized linear time.
+ * The buffers returned by value are moved, only the copying duplicates the memory.
+ * A buffer could be bound to a pool to reuse the memory blocks of the freed buffers.
+ * The small data (up to `VU_BUFFER_INLINE_SIZE` bytes) is stored inside the object without allocating.
  */
 
+#ifndef VU_BUFFER_INLINE_SIZE
+#define VU_BUFFER_INLINE_SIZE 64 // Set to 0 to disable, the library and its users must use the same value
+#endif // VU_BUFFER_INLINE_SIZE
+
 class Buffer
 {
 public:
@@ -983,32 +1287,45 @@ public:
   Buffer(const void* ptr, const size_t size);
   Buffer(const size_t size);
   Buffer(const Buffer& right);
+  Buffer(Buffer&& right);
   virtual ~Buffer();
 
   const Buffer& operator=(const Buffer& right);
+  const Buffer& operator=(Buffer&& right);
   bool  operator==(const Buffer& right) const;
   bool  operator!=(const Buffer& right) const;
   byte& operator[](const size_t offset);
-  Buffer operator()(int begin, int end) const;
+  Buffer operator()(intptr begin, intptr end) const;
 
   byte*  get_ptr_bytes() const;
   void*  get_ptr() const;
   size_t get_size() const;
+  size_t get_capacity() const;
 
   bool empty() const;
 
   void reset();
+  void swap(Buffer& right);
   void fill(const byte v = 0);
-  bool resize(const size_t size);
+  bool resize(const size_t size, const bool zero = true); // Skip the zeroing if it will be overwritten
+  bool reserve(const size_t capacity);
+  bool shrink_to_fit();
   bool replace(const void* ptr, const size_t size);
   bool replace(const Buffer& right);
+  bool replace(const BufferView& view);
   bool match(const void* ptr, const size_t size) const;
+  bool match(const Pattern& pattern) const;
   size_t find(const void* ptr, const size_t size) const;
+  size_t find(const Pattern& pattern) const;
+  size_t rfind(const void* ptr, const size_t size) const;
+  std::vector<size_t> find_all(const void* ptr, const size_t size) const; // The overlapped ones included
+  size_t count(const void* ptr, const size_t size) const;
   Buffer till(const void* ptr, const size_t size) const;
-  Buffer slice(int begin, int end) const;
+  Buffer slice(intptr begin, intptr end) const; // The negative indices are from the end
 
   bool append(const void* ptr, const size_t size);
   bool append(const Buffer& right);
+  bool append(const BufferView& view);
 
   std::string  to_string_A() const;
   std::wstring to_string_W() const;
@@ -1016,13 +1333,178 @@ public:
   bool save_to_file(const std::string&  file_path);
   bool save_to_file(const std::wstring& file_path);
 
+  BufferPool* get_pool() const;
+  bool set_pool(BufferPool* pool);
+
 private:
-  bool create(void* ptr, const size_t size, const bool clean = true);
+  bool create(const void* ptr, const size_t size);
   bool destroy();
+  bool is_inline() const;
+  void* allocate(const size_t size, size_t& capacity);
+  void  deallocate(void* ptr, const size_t capacity);
 
 private:
   void*  m_ptr;
   size_t m_size;
+  size_t m_capacity;
+  BufferPool* m_pool;
+  byte m_inline[VU_BUFFER_INLINE_SIZE > 0 ? VU_BUFFER_INLINE_SIZE : 1];
+};
+
+/**
+ * Buffer Chain
+ * The rope of the segments those are either the owned buffers or the views, the appending takes
+ * a constant time and the segments are never flattened, so they are written by the vectored I/O.
+ */
+
+class BufferChain
+{
+public:
+  BufferChain();
+  virtual ~BufferChain();
+
+  void append(const BufferView& view); // Not copied, the memory must outlive the chain
+  void append(const Buffer& buffer);   // Copied
+  void append(Buffer&& buffer);        // Moved
+
+  void clear();
+  size_t consume(const size_t size); // Remove the bytes from the front
+
+  bool   empty() const;
+  size_t get_size() const;
+  size_t count() const;
+  BufferView at(const size_t index) const;
+
+  Buffer flatten() const;
+
+private:
+  struct Segment
+  {
+    bool owned;
+    Buffer buffer;   // The data of an owned segment
+    BufferView view; // The data of a non-owned segment
+    size_t offset;   // The consumed bytes of the data
+
+    BufferView data() const;
+  };
+
+  std::deque<Segment> m_segments;
+  size_t m_size;
+};
+
+/**
+ * Pattern
+ * The array of bytes pattern that compiled once and reused for scanning, eg. "48 8B ?? 4? ?F".
+ * - `??` or `?` : any byte
+ * - `4?` or `?F` : half-byte wildcards, matched the high or the low nibble only
+ */
+
+class Pattern
+{
+public:
+  Pattern();
+  Pattern(const std::string&  pattern);
+  Pattern(const std::wstring& pattern);
+  Pattern(const void* ptr, const size_t size);
+  Pattern(const Pattern& right);
+  virtual ~Pattern();
+
+  const Pattern& operator=(const Pattern& right);
+  bool operator==(const Pattern& right) const;
+  bool operator!=(const Pattern& right) const;
+
+  bool compile(const std::string&  pattern);
+  bool compile(const std::wstring& pattern);
+  bool compile(const void* ptr, const size_t size);
+
+  bool   empty() const;
+  size_t size() const;
+
+  const byte* values() const;
+  const byte* masks() const;
+  const size_t* anchors() const;
+  const size_t* skips() const;
+
+private:
+  template <typename char_t>
+  bool parse(const char_t* ptr, const size_t length);
+  void prepare();
+
+private:
+  std::vector<byte> m_values;
+  std::vector<byte> m_masks;
+  size_t m_anchors[2];  // The offsets of two rarest fully-specified bytes
+  size_t m_skips[256];  // The shift by the last byte of the window (Boyer-Moore-Horspool)
+};
+
+/**
+ * PatternSet
+ * The set of patterns that scanned together in a single pass over the data (Aho-Corasick).
+ * Each pattern is located by the rarest run of its fully-specified bytes then verified entirely.
+ */
+
+class PatternSet
+{
+public:
+  typedef std::pair<size_t, size_t> THit; // (pattern id, offset)
+  typedef std::vector<THit> THits;
+
+  PatternSet();
+  PatternSet(const std::vector<Pattern>& patterns);
+  virtual ~PatternSet();
+
+  size_t add(const Pattern& pattern);
+  bool compile();
+  void clear();
+
+  bool   empty() const;
+  bool   ready() const;
+  size_t count() const;
+
+  const Pattern& get(const size_t id) const;
+
+  bool scan(const void* ptr, const size_t size, THits& hits, const bool first_match_only = false) const;
+  bool scan(const BufferView& view, THits& hits, const bool first_match_only = false) const;
+
+private:
+  std::vector<Pattern> m_patterns;
+  std::vector<size_t> m_key_offsets;    // The offset of the literal key of each pattern
+  std::vector<size_t> m_key_sizes;      // The size of the literal key of each pattern, zero if no key
+  std::vector<size_t> m_no_key_ids;     // The patterns that have no fully-specified byte
+  std::vector<uint32> m_transitions;    // The DFA [state * 256 + byte], high bit means has outputs
+  std::vector<uint32> m_output_links;   // The nearest suffix state that has outputs, zero if none
+  std::vector<size_t> m_output_begins;  // The outputs of a state [begins[state], begins[state + 1])
+  std::vector<size_t> m_output_ids;
+  size_t m_max_key_end;
+  bool m_ready;
+};
+
+/**
+ * PatternScanner
+ * The streaming scanner that scans the data chunk by chunk and reports the absolute offsets.
+ * The last `pattern.size() - 1` bytes are kept between the chunks to match across them.
+ */
+
+class PatternScanner
+{
+public:
+  PatternScanner(const Pattern& pattern, const bool first_match_only = false);
+  virtual ~PatternScanner();
+
+  void reset();
+  bool push(const void* ptr, const size_t size, std::vector<uint64>& offsets);
+
+  bool   done() const;
+  uint64 position() const;
+  const Pattern& pattern() const;
+
+private:
+  Pattern m_pattern;
+  bool m_first_match_only;
+  bool m_done;
+  uint64 m_position;
+  std::vector<byte> m_tail;
+  std::vector<byte> m_joint;
 };
 
 /**
@@ -1156,6 +1638,8 @@ public:
 
   IResult vuapi send(const char* ptr_data, int size, const flags_t flags = MSG_NONE);
   IResult vuapi send(const Buffer& data, const flags_t flags = MSG_NONE);
+  IResult vuapi send(const BufferView& data, const flags_t flags = MSG_NONE);
+  IResult vuapi send(const BufferChain& data, const flags_t flags = MSG_NONE);
 
   IResult vuapi recv(char* ptr_data, int size, const flags_t flags = MSG_NONE);
   IResult vuapi recv(Buffer& data, const flags_t flags = MSG_NONE);
@@ -1639,7 +2123,7 @@ public:
   virtual bool vuapi valid(HANDLE handle);
   virtual ulong vuapi get_file_size();
 
-  virtual const Buffer vuapi read_as_buffer();
+  virtual Buffer vuapi read_as_buffer();
   virtual bool vuapi read(void* ptr_buffer, ulong size);
   virtual bool vuapi read(
     ulong offset, void* ptr_buffer, ulong size, fs_position_at flags = fs_position_at::PA_BEGIN);
@@ -1647,6 +2131,7 @@ public:
   virtual bool vuapi write(const void* ptr_buffer, ulong size);
   virtual bool vuapi write(
     ulong offset, const void* ptr_buffer, ulong size, fs_position_at flags = fs_position_at::PA_BEGIN);
+  virtual bool vuapi write(const BufferChain& chain);
 
   virtual bool vuapi seek(ulong offset, fs_position_at flags);
   virtual bool vuapi io_control(
@@ -1885,6 +2370,7 @@ public:
   );
 
   ulong vuapi get_file_size();
+  uint64 vuapi get_file_size_ex();
   void vuapi close();
 
 protected:
@@ -3048,6 +3534,15 @@ public:
     const ulong type = DEF_SM_PAGE,
     const ulong protection = DEF_SM_PROTECTION);
 
+  bool scan_memory(
+    std::vector<size_t>& addresses,
+    const Pattern& pattern,
+    const std::string& module_name = "",
+    const bool first_match_only = false,
+    const ulong state = DEF_SM_STATE,
+    const ulong type = DEF_SM_PAGE,
+    const ulong protection = DEF_SM_PROTECTION);
+
 protected:
   virtual void parse();
 
@@ -3110,6 +3605,15 @@ public:
     const ulong type = DEF_SM_PAGE,
     const ulong protection = DEF_SM_PROTECTION);
 
+  bool scan_memory(
+    std::vector<size_t>& addresses,
+    const Pattern& pattern,
+    const std::wstring& module_name = L"",
+    const bool first_match_only = false,
+    const ulong state = DEF_SM_STATE,
+    const ulong type = DEF_SM_PAGE,
+    const ulong protection = DEF_SM_PROTECTION);
+
 protected:
   virtual void parse();
 
@@ -3118,6 +3622,270 @@ protected:
   modules m_modules;
 };
 
+/**
+ * Batch Reader
+ * Read many addresses or pointer chains of a process at once. The requests are sorted by their
+ * addresses and the nearby ones are merged into a single read, the pointer chains are resolved
+ * level by level so each level is a single batch, and the intermediate pointers are cached for a
+ * staleness window so the chains those share their levels are not read again.
+ */
+
+class BatchReader : public LastError
+{
+public:
+  struct Request
+  {
+    ulongptr address;
+    void* buffer;
+    size_t size;
+    bool result;
+  };
+
+  struct Chain
+  {
+    ulongptr address;           // The base address
+    std::vector<ulong> offsets; // The offsets of the levels as `read_memory_ex`
+  };
+
+  typedef std::vector<Request> TRequests;
+  typedef std::vector<Chain> TChains;
+
+public:
+  BatchReader(
+    const arch bit,
+    const HANDLE hp,
+    const ulong staleness = 0,    // The milliseconds to reuse the cached pointers, 0 to not cache
+    const size_t max_gap = 256);  // The maximum gap between the requests those are merged
+  virtual ~BatchReader();
+
+  // Read the requests, returns the number of the succeeded requests.
+  size_t read(TRequests& requests, const bool force = false);
+
+  // Resolve the value addresses of the chains, returns the number of the resolved chains.
+  size_t resolve(std::vector<ulongptr>& addresses, const TChains& chains);
+
+  // Read the values of the chains into the requests, the request addresses are the resolved ones.
+  size_t read(TRequests& requests, const TChains& chains, const bool force = false);
+
+  // Drop all cached pointers.
+  void invalidate();
+
+private:
+  struct Pointer
+  {
+    ulongptr value;
+    ulong tick;
+  };
+
+  arch m_bit;
+  HANDLE m_hp;
+  ulong m_staleness;
+  size_t m_max_gap;
+  std::vector<byte> m_buffer;
+  std::unordered_map<ulongptr, Pointer> m_pointers;
+};
+
+/**
+ * Scan Session
+ * The session keeps the candidate addresses of the previous scan per page with their previous
+ * values, so the next scans only re-read the pages that still have candidates, and the pages that
+ * their content hash is unchanged are not compared again. The candidates of a page are stored as
+ * a bitmap of its value slots when they are dense, or as the delta-encoded slots when sparse.
+ */
+
+enum class scan_value_type : int
+{
+  SVT_INT8,
+  SVT_UINT8,
+  SVT_INT16,
+  SVT_UINT16,
+  SVT_INT32,
+  SVT_UINT32,
+  SVT_INT64,
+  SVT_UINT64,
+  SVT_FLOAT,
+  SVT_DOUBLE,
+};
+
+enum class scan_compare_type : int
+{
+  SCT_UNKNOWN,   // The unknown initial value, all addresses are candidates (the first scan only)
+  SCT_EQUALS,    // The value equals the given value (within the tolerance for floating-point)
+  SCT_GREATER,   // The value is greater than the given value
+  SCT_LESS,      // The value is less than the given value
+  SCT_BETWEEN,   // The value is in the given range [value, upper]
+  SCT_CHANGED,   // The value changed since the previous scan
+  SCT_UNCHANGED, // The value unchanged since the previous scan
+  SCT_INCREASED, // The value increased since the previous scan
+  SCT_DECREASED, // The value decreased since the previous scan
+};
+
+struct ScanValue
+{
+  bool floating;
+  int64 integer;
+  double real;
+
+  ScanValue() : floating(false), integer(0), real(0.) {}
+
+  template <typename T>
+  ScanValue(const T value)
+    : floating(std::is_floating_point<T>::value), integer(int64(value)), real(double(value)) {}
+};
+
+class ScanSession : public LastError
+{
+public:
+  ScanSession(
+    ProcessX& process,
+    const scan_value_type type,
+    const bool aligned = true,
+    const double tolerance = 0.); // The tolerance of the floating-point comparisons
+  virtual ~ScanSession();
+
+  bool first_scan(
+    const scan_compare_type compare,
+    const ScanValue& value = ScanValue(),
+    const ScanValue& upper = ScanValue(),
+    const ulong state = DEF_SM_STATE,
+    const ulong type = MEM_ALL_TYPE,
+    const ulong protection = DEF_SM_PROTECTION);
+
+  bool next_scan(
+    const scan_compare_type compare,
+    const ScanValue& value = ScanValue(),
+    const ScanValue& upper = ScanValue());
+
+  void reset();
+
+  size_t count() const;
+  std::vector<ulongptr> addresses(const size_t max_count = -1) const;
+
+private:
+  struct Page
+  {
+    ulongptr address;
+    uint64 hash;                // The hash of the page content at the previous scan
+    size_t count;               // The number of candidates in the page
+    std::vector<uint64> bitmap; // The candidate slots if they are dense
+    std::vector<byte> deltas;   // The delta-encoded candidate slots if they are sparse
+    std::vector<byte> values;   // The whole page content or the packed values of candidates
+    bool whole;
+    bool tail;                  // The unaligned values at the end of the page can cross into the next page
+  };
+
+  size_t value_size() const;
+  size_t slot_step() const;
+  size_t slot_count() const;
+  size_t tail_size() const;
+
+  void get_slots(const Page& page, std::vector<ushort>& slots) const;
+  void set_slots(Page& page, const std::vector<ushort>& slots);
+  void set_slots(Page& page, const uint64* bitmap);
+
+  void scan_page(
+    Page& page,
+    const byte* ptr,
+    const scan_compare_type compare,
+    const ScanValue& value,
+    const ScanValue& upper);
+
+  template <typename T>
+  void scan_page_T(
+    Page& page,
+    const byte* ptr,
+    const scan_compare_type compare,
+    const ScanValue& value,
+    const ScanValue& upper);
+
+  void store_page(Page& page, const byte* ptr);
+
+private:
+  ProcessX& m_process;
+  scan_value_type m_type;
+  bool m_aligned;
+  double m_tolerance;
+  bool m_scanned;
+  size_t m_count;
+  std::vector<Page> m_pages;
+  std::vector<ushort> m_slots;
+};
+
+/**
+ * Pointer Scanner
+ * Find the static pointer paths to an address those survive the restarting of the process.
+ * The readable memory is indexed once as the pairs of pointer value and location sorted by value,
+ * the location is kept as its 32-bit slot in the indexed blocks to halve its size, then the paths are searched backwards from the address level by level in parallel, each path
+ * ends at a pointer that is located in a module image.
+ */
+
+class PointerScanner : public LastError
+{
+public:
+  struct PointerPath
+  {
+    ulongptr module;            // The base address of the module
+    ulongptr offset;            // The offset of the static pointer in the module
+    std::vector<ulong> offsets; // The offsets of the levels as `read_memory_ex`
+  };
+
+  typedef std::vector<PointerPath> TPaths;
+
+public:
+  PointerScanner(ProcessX& process);
+  virtual ~PointerScanner();
+
+  // Index the pointers of the readable memory, it is done by the first scan if not yet.
+  bool snapshot(const size_t n_threads = -1); // -1 for all processors
+
+  bool scan(
+    TPaths& paths,
+    const ulongptr address,
+    const size_t max_level = 5,
+    const ulong max_offset = 0x1000,
+    const size_t max_count = 100000,
+    const size_t n_threads = -1);
+
+  void reset();
+
+  size_t count() const;
+
+private:
+  struct Pointer
+  {
+    ulongptr value;
+    uint32 slot; // The index of the location in the slots of the pointer size of the indexed blocks
+  };
+
+  struct Image
+  {
+    ulongptr begin;
+    ulongptr end;
+    ulongptr base;
+  };
+
+  struct Context; // The shared limits and counter of a scan
+
+  const Image* find_image(const ulongptr address) const;
+
+  ulongptr location(const Pointer& pointer) const;
+
+  void search(
+    Context& context,
+    TPaths& paths,
+    std::vector<ulong>& offsets,
+    const ulongptr address,
+    const size_t first,
+    const size_t last) const;
+
+private:
+  ProcessX& m_process;
+  std::vector<Pointer> m_pointers;
+  std::vector<Image> m_images;
+  std::vector<ulongptr> m_blocks; // The addresses of the indexed blocks
+  size_t m_pointer_size;
+};
+
 /**
  * Single Process
  */
@@ -3509,6 +4277,9 @@ private:
 #define Registry RegistryW
 #define PEFileT PEFileTW
 #define Path PathW
+#define StringView StringViewW
+#define Tokenizer TokenizerW
+#define QueryParam QueryParamW
 #define ScopeStopWatch ScopeStopWatchW
 #define WMIProvider WMIProviderW
 #define Fundamental FundamentalW
@@ -3528,6 +4299,9 @@ private:
 #define Registry RegistryA
 #define PEFileT PEFileTA
 #define Path PathA
+#define StringView StringViewA
+#define Tokenizer TokenizerA
+#define QueryParam QueryParamA
 #define ScopeStopWatch ScopeStopWatchA
 #define WMIProvider WMIProviderA
 #define Fundamental FundamentalA
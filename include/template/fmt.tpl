@@ -0,0 +1,961 @@
+/**
+ * @file   fmt.tpl
+ * @author Vic P.
+ * @brief  Template for Formatting
+ */
+
+// Numbers
+
+#define VU_FMT_NUMBER_SIZE 72 // The room for a 64-bit number in any base with its sign and prefix
+
+/**
+ * Write the digits of a number backward from the end of a buffer of `VU_FMT_NUMBER_SIZE` characters.
+ * @return The first written character.
+ */
+template <typename T>
+T* fmt_write_unsigned(T* end, uint64 v, const int base = 10, const bool upper = false)
+{
+  static const char pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+  if (base == 10)
+  {
+    while (v >= 100)
+    {
+      const size_t i = size_t(v % 100) * 2;
+      v /= 100;
+      *--end = T(pairs[i + 1]);
+      *--end = T(pairs[i]);
+    }
+
+    if (v >= 10)
+    {
+      *--end = T(pairs[v * 2 + 1]);
+      *--end = T(pairs[v * 2]);
+    }
+    else
+    {
+      *--end = T('0' + v);
+    }
+  }
+  else
+  {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    const int shift = base == 16 ? 4 : base == 8 ? 3 : 1;
+    const uint64 mask = (uint64(1) << shift) - 1;
+
+    do
+    {
+      *--end = T(digits[v & mask]);
+      v >>= shift;
+    } while (v != 0);
+  }
+
+  return end;
+}
+
+template <typename T>
+T* fmt_write_signed(T* end, const int64 v)
+{
+  T* begin = fmt_write_unsigned(end, v < 0 ? 0 - uint64(v) : uint64(v));
+  if (v < 0)
+  {
+    *--begin = T('-');
+  }
+
+  return begin;
+}
+
+#if ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || (__cplusplus >= 201703L))
+
+/**
+ * fmt
+ * The type-safe formatting by the `{}` placeholders, eg. fmt("{} = {:08x}", name, value).
+ * The spec of a placeholder is `{:[<|>][0][width][.precision][type]}`, the types are
+ *  b, d, o, x, X : the integers in the bases 2, 10, 8 and 16
+ *  e, f, g       : the floating points in the scientific, the fixed and the general notations
+ *  c, s, p       : the characters, the strings (and the booleans) and the pointers
+ * `{{` and `}}` are the escaped braces. The floating points are formatted to the shortest text that
+ * reads back to the same value by std::to_chars if the standard library has it.
+ * The format strings of VU_FMT are checked at compile time (the placeholders, the specs and the types
+ * of the arguments), the others are checked at runtime and their mismatched placeholders are kept as is.
+ * The text is formatted into a stack buffer and only moved to the heap if it grows over the buffer.
+ */
+
+#define VU_FMT_STACK_SIZE 512 // The characters that are formatted without any allocation
+
+#define VU_FMT_MAX_WIDTH 256
+#define VU_FMT_MAX_PRECISION 100
+
+enum class fmt_arg_type : int
+{
+  FA_NONE    = 0,
+  FA_BOOL    = 1,
+  FA_CHAR    = 2,
+  FA_INT     = 3,
+  FA_UINT    = 4,
+  FA_FLOAT   = 5,
+  FA_DOUBLE  = 6,
+  FA_STRING  = 7,
+  FA_POINTER = 8,
+};
+
+enum class fmt_error : int
+{
+  FE_OK             = 0,
+  FE_MALFORMED      = 1, // An unmatched brace or an invalid spec
+  FE_TOO_FEW_ARGS   = 2,
+  FE_TOO_MANY_ARGS  = 3,
+  FE_TYPE_MISMATCH  = 4, // The type of a spec does not accept its argument
+};
+
+struct FormatSpec
+{
+  char align = 0; // '<', '>' or 0 for the default of the argument
+  bool zero = false;
+  int  width = 0;
+  int  precision = -1;
+  char type = 0;
+};
+
+template <typename A>
+struct fmt_unsupported : std::false_type {};
+
+/**
+ * The type of an argument for the formatted characters of `T`, the narrow strings only accept the narrow
+ * characters and strings, the wide strings accept both characters.
+ */
+template <typename T, typename A>
+constexpr fmt_arg_type fmt_type_of()
+{
+  typedef std::remove_cv_t<std::remove_reference_t<A>> U;
+
+  if constexpr (std::is_same_v<U, bool>)
+  {
+    return fmt_arg_type::FA_BOOL;
+  }
+  else if constexpr (std::is_same_v<U, T> || std::is_same_v<U, char>)
+  {
+    return fmt_arg_type::FA_CHAR;
+  }
+  else if constexpr (
+    std::is_same_v<U, wchar_t> || std::is_same_v<U, char16_t> || std::is_same_v<U, char32_t>)
+  {
+    return fmt_arg_type::FA_NONE;
+  }
+  else if constexpr (std::is_enum_v<U>)
+  {
+    return std::is_signed_v<std::underlying_type_t<U>> ? fmt_arg_type::FA_INT : fmt_arg_type::FA_UINT;
+  }
+  else if constexpr (std::is_integral_v<U>)
+  {
+    return std::is_signed_v<U> ? fmt_arg_type::FA_INT : fmt_arg_type::FA_UINT;
+  }
+  else if constexpr (std::is_same_v<U, float>)
+  {
+    return fmt_arg_type::FA_FLOAT;
+  }
+  else if constexpr (std::is_floating_point_v<U>)
+  {
+    return fmt_arg_type::FA_DOUBLE;
+  }
+  else if constexpr (
+    std::is_same_v<U, std::basic_string<T>> ||
+    std::is_same_v<U, StringViewT<T>> ||
+    std::is_convertible_v<const U&, const T*>)
+  {
+    return fmt_arg_type::FA_STRING;
+  }
+  else if constexpr (std::is_pointer_v<std::decay_t<U>> || std::is_null_pointer_v<U>)
+  {
+    return std::is_convertible_v<std::decay_t<U>, const char*> ||
+           std::is_convertible_v<std::decay_t<U>, const wchar_t*> ? fmt_arg_type::FA_NONE : fmt_arg_type::FA_POINTER;
+  }
+  else
+  {
+    return fmt_arg_type::FA_NONE;
+  }
+}
+
+constexpr bool fmt_accepts(const fmt_arg_type type, const FormatSpec& spec)
+{
+  const bool integer = type == fmt_arg_type::FA_INT || type == fmt_arg_type::FA_UINT;
+  const bool floating = type == fmt_arg_type::FA_FLOAT || type == fmt_arg_type::FA_DOUBLE;
+
+  if (spec.precision >= 0 && !floating && type != fmt_arg_type::FA_STRING)
+  {
+    return false;
+  }
+
+  switch (spec.type)
+  {
+  case 0:
+    return type != fmt_arg_type::FA_NONE;
+  case 'd':
+    return integer || type == fmt_arg_type::FA_CHAR || type == fmt_arg_type::FA_BOOL;
+  case 'b': case 'o': case 'x': case 'X':
+    return integer || type == fmt_arg_type::FA_CHAR;
+  case 'c':
+    return integer || type == fmt_arg_type::FA_CHAR;
+  case 'e': case 'f': case 'g':
+    return floating;
+  case 's':
+    return type == fmt_arg_type::FA_STRING || type == fmt_arg_type::FA_CHAR || type == fmt_arg_type::FA_BOOL;
+  case 'p':
+    return type == fmt_arg_type::FA_POINTER;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Parse the placeholder that starts at `s[i]` (after its '{').
+ * @return The offset after its '}', or 0 if it is malformed.
+ */
+template <typename T>
+constexpr size_t fmt_parse_spec(const T* s, const size_t length, size_t i, FormatSpec& spec)
+{
+  if (i < length && s[i] == T('}'))
+  {
+    return i + 1;
+  }
+
+  if (i >= length || s[i] != T(':'))
+  {
+    return 0;
+  }
+
+  i++;
+
+  if (i < length && (s[i] == T('<') || s[i] == T('>')))
+  {
+    spec.align = char(s[i++]);
+  }
+
+  if (i < length && s[i] == T('0'))
+  {
+    spec.zero = true;
+    i++;
+  }
+
+  for (; i < length && s[i] >= T('0') && s[i] <= T('9'); i++)
+  {
+    spec.width = 10 * spec.width + int(s[i] - T('0'));
+    if (spec.width > VU_FMT_MAX_WIDTH)
+    {
+      return 0;
+    }
+  }
+
+  if (i < length && s[i] == T('.'))
+  {
+    i++;
+
+    if (i >= length || s[i] < T('0') || s[i] > T('9'))
+    {
+      return 0;
+    }
+
+    spec.precision = 0;
+
+    for (; i < length && s[i] >= T('0') && s[i] <= T('9'); i++)
+    {
+      spec.precision = 10 * spec.precision + int(s[i] - T('0'));
+      if (spec.precision > VU_FMT_MAX_PRECISION)
+      {
+        return 0;
+      }
+    }
+  }
+
+  if (i < length && s[i] != T('}'))
+  {
+    const T c = s[i++];
+    if (c != T('b') && c != T('c') && c != T('d') && c != T('e') && c != T('f') && c != T('g') &&
+        c != T('o') && c != T('p') && c != T('s') && c != T('x') && c != T('X'))
+    {
+      return 0;
+    }
+
+    spec.type = char(c);
+  }
+
+  if (i >= length || s[i] != T('}'))
+  {
+    return 0;
+  }
+
+  return i + 1;
+}
+
+template <typename T>
+constexpr size_t fmt_length(const T* s)
+{
+  size_t n = 0;
+  while (s[n] != T(0))
+  {
+    n++;
+  }
+
+  return n;
+}
+
+template <typename T>
+constexpr fmt_error fmt_check(const T* s, const fmt_arg_type* types, const size_t n)
+{
+  const size_t length = fmt_length(s);
+
+  size_t index = 0;
+
+  for (size_t i = 0; i < length; i++)
+  {
+    if (s[i] == T('}'))
+    {
+      if (i + 1 >= length || s[i + 1] != T('}'))
+      {
+        return fmt_error::FE_MALFORMED;
+      }
+
+      i++;
+    }
+    else if (s[i] == T('{'))
+    {
+      if (i + 1 < length && s[i + 1] == T('{'))
+      {
+        i++;
+        continue;
+      }
+
+      FormatSpec spec;
+      const size_t end = fmt_parse_spec(s, length, i + 1, spec);
+      if (end == 0)
+      {
+        return fmt_error::FE_MALFORMED;
+      }
+
+      if (index >= n)
+      {
+        return fmt_error::FE_TOO_FEW_ARGS;
+      }
+
+      if (!fmt_accepts(types[index++], spec))
+      {
+        return fmt_error::FE_TYPE_MISMATCH;
+      }
+
+      i = end - 1;
+    }
+  }
+
+  return index == n ? fmt_error::FE_OK : fmt_error::FE_TOO_MANY_ARGS;
+}
+
+/**
+ * FormatStringBase
+ * The base of the format strings of VU_FMT, their texts are constant expressions.
+ */
+
+struct FormatStringBase {};
+
+#define VU_FMT(s) [] \
+{ \
+  struct FormatString : vu::FormatStringBase \
+  { \
+    static constexpr const auto* data() { return s; } \
+  }; \
+  return FormatString(); \
+}()
+
+template <typename S>
+using fmt_char_t = std::remove_const_t<std::remove_pointer_t<decltype(S::data())>>;
+
+template <typename S>
+using fmt_enable_if_format_string_t = std::enable_if_t<std::is_base_of_v<FormatStringBase, S>, int>;
+
+/**
+ * FormatBufferT
+ * The buffer of the formatted text, it starts in itself and moves to the heap if it grows over that.
+ * Bound to a string, it writes after the end of the string in place and uses its spare capacity first.
+ */
+
+template <typename T>
+class FormatBufferT
+{
+public:
+  FormatBufferT() : m_target(nullptr), m_ptr(m_stack), m_size(0), m_capacity(VU_FMT_STACK_SIZE) {}
+
+  explicit FormatBufferT(std::basic_string<T>& target)
+    : m_target(&target), m_ptr(&target[0]), m_size(target.size()), m_capacity(target.size()) {}
+
+  ~FormatBufferT()
+  {
+    if (m_target != nullptr)
+    {
+      m_target->resize(m_size);
+    }
+  }
+
+  FormatBufferT(const FormatBufferT&) = delete;
+  FormatBufferT& operator=(const FormatBufferT&) = delete;
+
+  const T* data() const
+  {
+    return m_ptr;
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  T* prepare(const size_t n) // The room for `n` more characters, they are kept by commit(n)
+  {
+    if (m_size + n > m_capacity)
+    {
+      this->grow(m_size + n);
+    }
+
+    return m_ptr + m_size;
+  }
+
+  void commit(const size_t n)
+  {
+    m_size += n;
+  }
+
+  void append(const T* ptr, const size_t n)
+  {
+    std::char_traits<T>::copy(this->prepare(n), ptr, n);
+    m_size += n;
+  }
+
+  void append(const size_t n, const T c)
+  {
+    std::char_traits<T>::assign(this->prepare(n), n, c);
+    m_size += n;
+  }
+
+private:
+  void grow(const size_t n)
+  {
+    if (m_target != nullptr)
+    {
+      size_t size = m_target->capacity();
+      if (size < n)
+      {
+        size = 2 * m_capacity > n ? 2 * m_capacity : n;
+      }
+
+      m_target->resize(size);
+      m_ptr = &(*m_target)[0];
+      m_capacity = size;
+      return;
+    }
+
+    const size_t capacity = 2 * m_capacity > n ? 2 * m_capacity : n;
+
+    std::unique_ptr<T[]> heap(new T[capacity]);
+    std::char_traits<T>::copy(heap.get(), m_ptr, m_size);
+
+    m_heap.swap(heap);
+    m_ptr = m_heap.get();
+    m_capacity = capacity;
+  }
+
+private:
+  T m_stack[VU_FMT_STACK_SIZE];
+  std::unique_ptr<T[]> m_heap;
+  std::basic_string<T>* m_target;
+  T* m_ptr;
+  size_t m_size;
+  size_t m_capacity;
+};
+
+/**
+ * FormatArgT
+ * The type-erased argument, the strings are referred and not copied.
+ */
+
+template <typename T>
+struct FormatArgT
+{
+  struct Text
+  {
+    const T* ptr;
+    size_t size;
+  };
+
+  fmt_arg_type type;
+
+  union
+  {
+    bool b;
+    T c;
+    int64 i;
+    uint64 u;
+    float f;
+    double d;
+    Text s;
+    const void* p;
+  };
+
+  FormatArgT() : type(fmt_arg_type::FA_NONE), u(0) {}
+};
+
+template <typename T, typename A>
+FormatArgT<T> fmt_make_arg(const A& v)
+{
+  constexpr fmt_arg_type type = fmt_type_of<T, A>();
+  static_assert(type != fmt_arg_type::FA_NONE || fmt_unsupported<A>::value, "the type is not supported by fmt");
+
+  FormatArgT<T> arg;
+  arg.type = type;
+
+  if constexpr (type == fmt_arg_type::FA_BOOL)
+  {
+    arg.b = v;
+  }
+  else if constexpr (type == fmt_arg_type::FA_CHAR)
+  {
+    arg.c = T(v);
+  }
+  else if constexpr (type == fmt_arg_type::FA_INT)
+  {
+    arg.i = int64(v);
+  }
+  else if constexpr (type == fmt_arg_type::FA_UINT)
+  {
+    arg.u = uint64(v);
+  }
+  else if constexpr (type == fmt_arg_type::FA_FLOAT)
+  {
+    arg.f = v;
+  }
+  else if constexpr (type == fmt_arg_type::FA_DOUBLE)
+  {
+    arg.d = double(v);
+  }
+  else if constexpr (std::is_same_v<A, std::basic_string<T>> || std::is_same_v<A, StringViewT<T>>)
+  {
+    arg.s.ptr = v.data();
+    arg.s.size = v.size();
+  }
+  else if constexpr (type == fmt_arg_type::FA_STRING)
+  {
+    const T* ptr = v;
+    arg.s.ptr = ptr;
+    arg.s.size = ptr != nullptr ? std::char_traits<T>::length(ptr) : 0;
+  }
+  else
+  {
+    arg.p = static_cast<const void*>(v);
+  }
+
+  return arg;
+}
+
+/**
+ * Write a floating point to the buffer of `VU_FMT_STACK_SIZE` characters.
+ * @return The number of the written characters.
+ */
+template <typename F>
+size_t fmt_write_floating(char* buffer, const F v, const FormatSpec& spec)
+{
+  const char type = spec.type == 0 && spec.precision >= 0 ? 'g' : spec.type;
+  const int precision = spec.precision >= 0 ? spec.precision : 6;
+
+  #if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+
+  char* end = buffer + VU_FMT_STACK_SIZE;
+
+  std::to_chars_result result;
+
+  switch (type)
+  {
+  case 'e':
+    result = std::to_chars(buffer, end, v, std::chars_format::scientific, precision);
+    break;
+  case 'f':
+    result = std::to_chars(buffer, end, v, std::chars_format::fixed, precision);
+    break;
+  case 'g':
+    result = std::to_chars(buffer, end, v, std::chars_format::general, precision);
+    break;
+  default:
+    result = std::to_chars(buffer, end, v);
+    break;
+  }
+
+  return result.ec == std::errc() ? size_t(result.ptr - buffer) : 0;
+
+  #else // the standard library has no std::to_chars of the floating points
+
+  int n = 0;
+
+  if (type == 0)
+  {
+    // the shortest of the common precisions that reads back to the same value
+
+    const int precisions[] = { std::numeric_limits<F>::digits10, std::numeric_limits<F>::max_digits10 };
+
+    for (const auto p : precisions)
+    {
+      n = snprintf(buffer, VU_FMT_STACK_SIZE, "%.*g", p, double(v));
+      if (F(strtod(buffer, nullptr)) == v || v != v)
+      {
+        break;
+      }
+    }
+  }
+  else
+  {
+    const char pattern[] = { '%', '.', '*', type, '\0' };
+    n = snprintf(buffer, VU_FMT_STACK_SIZE, pattern, precision, double(v));
+  }
+
+  return n > 0 && n < VU_FMT_STACK_SIZE ? size_t(n) : 0;
+
+  #endif
+}
+
+template <typename T>
+void fmt_write_padded(
+  FormatBufferT<T>& buffer,
+  const FormatSpec& spec,
+  const char default_align,
+  const T* prefix, const size_t prefix_size,
+  const T* body, const size_t body_size)
+{
+  const size_t size = prefix_size + body_size;
+  const size_t padding = size_t(spec.width) > size ? size_t(spec.width) - size : 0;
+
+  if (spec.zero && default_align == '>')
+  {
+    buffer.append(prefix, prefix_size);
+    buffer.append(padding, T('0'));
+    buffer.append(body, body_size);
+    return;
+  }
+
+  const bool left = (spec.align != 0 ? spec.align : default_align) == '<';
+
+  if (!left)
+  {
+    buffer.append(padding, T(' '));
+  }
+
+  buffer.append(prefix, prefix_size);
+  buffer.append(body, body_size);
+
+  if (left)
+  {
+    buffer.append(padding, T(' '));
+  }
+}
+
+template <typename T>
+void fmt_write_integer(FormatBufferT<T>& buffer, const FormatSpec& spec, const uint64 v, const bool negative)
+{
+  const T minus[] = { T('-') };
+
+  T digits[VU_FMT_NUMBER_SIZE];
+  T* end = digits + VU_FMT_NUMBER_SIZE;
+  T* begin = end;
+
+  switch (spec.type)
+  {
+  case 'b':
+    begin = fmt_write_unsigned(end, v, 2);
+    break;
+  case 'o':
+    begin = fmt_write_unsigned(end, v, 8);
+    break;
+  case 'x':
+  case 'X':
+    begin = fmt_write_unsigned(end, v, 16, spec.type == 'X');
+    break;
+  default:
+    begin = fmt_write_unsigned(end, v);
+    break;
+  }
+
+  fmt_write_padded(buffer, spec, '>', minus, negative ? 1 : 0, begin, size_t(end - begin));
+}
+
+template <typename T>
+void fmt_write_arg(FormatBufferT<T>& buffer, const FormatSpec& spec, const FormatArgT<T>& arg)
+{
+  switch (arg.type)
+  {
+  case fmt_arg_type::FA_BOOL:
+    if (spec.type == 'd')
+    {
+      fmt_write_integer(buffer, spec, arg.b ? 1 : 0, false);
+    }
+    else
+    {
+      const T text[] = { T('t'), T('r'), T('u'), T('e'), T('f'), T('a'), T('l'), T('s'), T('e') };
+      fmt_write_padded<T>(buffer, spec, '<', nullptr, 0, arg.b ? text : text + 4, arg.b ? 4 : 5);
+    }
+    break;
+
+  case fmt_arg_type::FA_CHAR:
+    if (spec.type == 0 || spec.type == 'c' || spec.type == 's')
+    {
+      fmt_write_padded<T>(buffer, spec, '<', nullptr, 0, &arg.c, 1);
+    }
+    else
+    {
+      fmt_write_integer(buffer, spec, uint64(std::make_unsigned_t<T>(arg.c)), false);
+    }
+    break;
+
+  case fmt_arg_type::FA_INT:
+    if (spec.type == 'c')
+    {
+      const T c = T(arg.i);
+      fmt_write_padded<T>(buffer, spec, '<', nullptr, 0, &c, 1);
+    }
+    else
+    {
+      fmt_write_integer(buffer, spec, arg.i < 0 ? 0 - uint64(arg.i) : uint64(arg.i), arg.i < 0);
+    }
+    break;
+
+  case fmt_arg_type::FA_UINT:
+    if (spec.type == 'c')
+    {
+      const T c = T(arg.u);
+      fmt_write_padded<T>(buffer, spec, '<', nullptr, 0, &c, 1);
+    }
+    else
+    {
+      fmt_write_integer(buffer, spec, arg.u, false);
+    }
+    break;
+
+  case fmt_arg_type::FA_FLOAT:
+  case fmt_arg_type::FA_DOUBLE:
+    {
+      char text[VU_FMT_STACK_SIZE];
+      const size_t n = arg.type == fmt_arg_type::FA_FLOAT ?
+        fmt_write_floating(text, arg.f, spec) : fmt_write_floating(text, arg.d, spec);
+
+      const bool negative = n != 0 && text[0] == '-';
+      const bool finite = std::isfinite(arg.type == fmt_arg_type::FA_FLOAT ? double(arg.f) : arg.d);
+
+      T body[VU_FMT_STACK_SIZE];
+      for (size_t i = 0; i < n; i++)
+      {
+        body[i] = T(text[i]);
+      }
+
+      const T minus[] = { T('-') };
+
+      FormatSpec s = spec;
+      s.zero = spec.zero && finite;
+
+      fmt_write_padded(
+        buffer, s, '>', minus, negative ? 1 : 0, body + (negative ? 1 : 0), n - (negative ? 1 : 0));
+    }
+    break;
+
+  case fmt_arg_type::FA_STRING:
+    {
+      const size_t n = spec.precision >= 0 && size_t(spec.precision) < arg.s.size ? spec.precision : arg.s.size;
+      fmt_write_padded<T>(buffer, spec, '<', nullptr, 0, arg.s.ptr, n);
+    }
+    break;
+
+  case fmt_arg_type::FA_POINTER:
+    {
+      const T prefix[] = { T('0'), T('x') };
+
+      T digits[VU_FMT_NUMBER_SIZE];
+      T* end = digits + VU_FMT_NUMBER_SIZE;
+      T* begin = fmt_write_unsigned(end, uint64(reinterpret_cast<ulongptr>(arg.p)), 16);
+
+      fmt_write_padded(buffer, spec, '>', prefix, 2, begin, size_t(end - begin));
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+template <typename T>
+void fmt_vformat(
+  FormatBufferT<T>& buffer,
+  const T* format_string,
+  const size_t length,
+  const FormatArgT<T>* args,
+  const size_t n)
+{
+  size_t index = 0;
+  size_t literal = 0; // the start of the pending literal text
+
+  for (size_t i = 0; i < length; i++)
+  {
+    const T c = format_string[i];
+    if (c != T('{') && c != T('}'))
+    {
+      continue;
+    }
+
+    buffer.append(format_string + literal, i - literal);
+    literal = i;
+
+    // the escaped braces are kept as a single brace, a lone '}' is kept as is
+
+    if (i + 1 < length && format_string[i + 1] == c)
+    {
+      literal = ++i;
+      continue;
+    }
+
+    if (c == T('}'))
+    {
+      continue;
+    }
+
+    FormatSpec spec;
+    const size_t end = fmt_parse_spec(format_string, length, i + 1, spec);
+    if (end == 0)
+    {
+      continue; // the malformed placeholder is kept in the literal text
+    }
+
+    if (index < n && fmt_accepts(args[index].type, spec))
+    {
+      fmt_write_arg(buffer, spec, args[index]);
+      literal = end;
+    }
+
+    index++;
+    i = end - 1;
+  }
+
+  buffer.append(format_string + literal, length - literal);
+}
+
+template <typename T, typename... Args>
+void fmt_format(FormatBufferT<T>& buffer, const T* format_string, const size_t length, const Args&... args)
+{
+  const FormatArgT<T> array[] = { fmt_make_arg<T>(args)..., FormatArgT<T>() };
+  fmt_vformat(buffer, format_string, length, array, sizeof...(Args));
+}
+
+/**
+ * The text is formatted into the string in place, unless the format string or an argument is in the storage
+ * of the string since the growing of the string would free them, then it is formatted aside and appended.
+ */
+
+template <typename T>
+bool fmt_overlaps(const std::basic_string<T>& result, const T* ptr, const size_t size)
+{
+  const std::less_equal<const T*> less_equal;
+  const T* begin = result.data();
+  const T* end = begin + result.capacity() + 1;
+  return less_equal(begin, ptr + size) && less_equal(ptr, end);
+}
+
+template <typename T, typename... Args>
+void fmt_format_to(std::basic_string<T>& result, const T* format_string, const size_t length, const Args&... args)
+{
+  const FormatArgT<T> array[] = { fmt_make_arg<T>(args)..., FormatArgT<T>() };
+
+  bool overlapped = fmt_overlaps(result, format_string, length);
+
+  for (size_t i = 0; i < sizeof...(Args) && !overlapped; i++)
+  {
+    overlapped = array[i].type == fmt_arg_type::FA_STRING && fmt_overlaps(result, array[i].s.ptr, array[i].s.size);
+  }
+
+  if (overlapped)
+  {
+    FormatBufferT<T> buffer;
+    fmt_vformat(buffer, format_string, length, array, sizeof...(Args));
+    result.append(buffer.data(), buffer.size());
+  }
+  else
+  {
+    FormatBufferT<T> buffer(result);
+    fmt_vformat(buffer, format_string, length, array, sizeof...(Args));
+  }
+}
+
+template <typename S, typename... Args>
+void fmt_static_check()
+{
+  typedef fmt_char_t<S> T;
+
+  constexpr fmt_arg_type types[] = { fmt_type_of<T, Args>()..., fmt_arg_type::FA_NONE };
+  constexpr fmt_error error = fmt_check(S::data(), types, sizeof...(Args));
+
+  static_assert(error != fmt_error::FE_MALFORMED, "fmt: the format string is malformed");
+  static_assert(error != fmt_error::FE_TOO_FEW_ARGS, "fmt: too few arguments for the format string");
+  static_assert(error != fmt_error::FE_TOO_MANY_ARGS, "fmt: too many arguments for the format string");
+  static_assert(error != fmt_error::FE_TYPE_MISMATCH, "fmt: an argument does not match its placeholder");
+}
+
+/**
+ * Format the arguments to a new string.
+ */
+
+template <typename T, typename... Args>
+std::basic_string<T> fmt(const T* format_string, const Args&... args)
+{
+  FormatBufferT<T> buffer;
+  fmt_format(buffer, format_string, std::char_traits<T>::length(format_string), args...);
+  return std::basic_string<T>(buffer.data(), buffer.size());
+}
+
+template <typename T, typename... Args>
+std::basic_string<T> fmt(const std::basic_string<T>& format_string, const Args&... args)
+{
+  FormatBufferT<T> buffer;
+  fmt_format(buffer, format_string.data(), format_string.size(), args...);
+  return std::basic_string<T>(buffer.data(), buffer.size());
+}
+
+template <typename S, typename... Args, fmt_enable_if_format_string_t<S> = 0>
+std::basic_string<fmt_char_t<S>> fmt(const S&, const Args&... args)
+{
+  fmt_static_check<S, Args...>();
+  return fmt(S::data(), args...);
+}
+
+/**
+ * Format the arguments to the end of an existing string.
+ */
+
+template <typename T, typename... Args>
+void fmt_to(std::basic_string<T>& result, const T* format_string, const Args&... args)
+{
+  fmt_format_to(result, format_string, std::char_traits<T>::length(format_string), args...);
+}
+
+template <typename T, typename... Args>
+void fmt_to(std::basic_string<T>& result, const std::basic_string<T>& format_string, const Args&... args)
+{
+  fmt_format_to(result, format_string.data(), format_string.size(), args...);
+}
+
+template <typename S, typename... Args, fmt_enable_if_format_string_t<S> = 0>
+void fmt_to(std::basic_string<fmt_char_t<S>>& result, const S&, const Args&... args)
+{
+  fmt_static_check<S, Args...>();
+  fmt_to(result, S::data(), args...);
+}
+
+#endif // C++17
@@ -0,0 +1,344 @@
+/**
+ * @file   casefold.cpp
+ * @author Vic P.
+ * @brief  Implementation for Case Folding
+ */
+
+#include "casefold.h"
+#include "simd.h"
+
+namespace vu
+{
+
+/**
+ * ASCII
+ * The bytes of 'A'..'Z' are folded to 'a'..'z' by setting their 0x20 bit, the others are kept as is.
+ */
+
+static inline byte fold_ascii(const byte c)
+{
+  return uint32(c) - 'A' < 26 ? byte(c | 0x20) : c;
+}
+
+static bool equal_ignore_case_scalar(const byte* left, const byte* right, const size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    if (left[i] != right[i] && fold_ascii(left[i]) != fold_ascii(right[i]))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static size_t find_ignore_case_scalar(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  const byte first = fold_ascii(needle[0]);
+  const byte last  = fold_ascii(needle[length - 1]);
+
+  for (size_t i = 0; i + length <= size; i++)
+  {
+    if (fold_ascii(ptr[i]) == first &&
+        fold_ascii(ptr[i + length - 1]) == last &&
+        equal_ignore_case_scalar(ptr + i + 1, needle + 1, length < 2 ? 0 : length - 2))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+#ifdef VU_SIMD_X86
+
+/**
+ * SSE2
+ * The bytes are shifted so 'A'..'Z' become the lowest signed bytes, then a single signed compare
+ * selects them for folding.
+ */
+
+VU_TARGET_SSE2 static inline __m128i fold_sse2(const __m128i v)
+{
+  const auto shifted = _mm_add_epi8(v, _mm_set1_epi8(char(0x80 - 'A')));
+  const auto upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(char(-0x80 + 26)));
+  return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+VU_TARGET_SSE2 static bool equal_ignore_case_sse2(const byte* left, const byte* right, const size_t length)
+{
+  size_t i = 0;
+
+  for (; i + 16 <= length; i += 16)
+  {
+    const auto l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+    const auto r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(fold_sse2(l), fold_sse2(r))) != 0xFFFF)
+    {
+      return false;
+    }
+  }
+
+  return equal_ignore_case_scalar(left + i, right + i, length - i);
+}
+
+VU_TARGET_SSE2 static size_t find_ignore_case_sse2(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  const auto v1 = _mm_set1_epi8(char(fold_ascii(needle[0])));
+  const auto v2 = _mm_set1_epi8(char(fold_ascii(needle[length - 1])));
+
+  const size_t n_starts = size - length + 1;
+
+  size_t i = 0;
+
+  for (; i + 16 <= n_starts; i += 16)
+  {
+    const auto d1 = fold_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i)));
+    const auto d2 = fold_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i + length - 1)));
+    uint32 candidates = uint32(_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(d1, v1), _mm_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const size_t offset = i + bit_scan_forward(candidates);
+      if (length <= 2 || equal_ignore_case_sse2(ptr + offset + 1, needle + 1, length - 2))
+      {
+        return offset;
+      }
+
+      candidates &= candidates - 1;
+    }
+  }
+
+  const size_t offset = find_ignore_case_scalar(ptr + i, size - i, needle, length);
+  return offset == -1 ? -1 : i + offset;
+}
+
+/**
+ * AVX2
+ */
+
+VU_TARGET_AVX2 static inline __m256i fold_avx2(const __m256i v)
+{
+  const auto shifted = _mm256_add_epi8(v, _mm256_set1_epi8(char(0x80 - 'A')));
+  const auto upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(char(-0x80 + 26)), shifted);
+  return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+VU_TARGET_AVX2 static bool equal_ignore_case_avx2(const byte* left, const byte* right, const size_t length)
+{
+  size_t i = 0;
+
+  for (; i + 32 <= length; i += 32)
+  {
+    const auto l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+    const auto r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+    if (uint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(fold_avx2(l), fold_avx2(r)))) != 0xFFFFFFFF)
+    {
+      return false;
+    }
+  }
+
+  return equal_ignore_case_scalar(left + i, right + i, length - i);
+}
+
+VU_TARGET_AVX2 static size_t find_ignore_case_avx2(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  const auto v1 = _mm256_set1_epi8(char(fold_ascii(needle[0])));
+  const auto v2 = _mm256_set1_epi8(char(fold_ascii(needle[length - 1])));
+
+  const size_t n_starts = size - length + 1;
+
+  size_t i = 0;
+
+  for (; i + 32 <= n_starts; i += 32)
+  {
+    const auto d1 = fold_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i)));
+    const auto d2 = fold_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i + length - 1)));
+    uint32 candidates = uint32(_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(d1, v1), _mm256_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const size_t offset = i + bit_scan_forward(candidates);
+      if (length <= 2 || equal_ignore_case_avx2(ptr + offset + 1, needle + 1, length - 2))
+      {
+        return offset;
+      }
+
+      candidates &= candidates - 1;
+    }
+  }
+
+  const size_t offset = find_ignore_case_scalar(ptr + i, size - i, needle, length);
+  return offset == -1 ? -1 : i + offset;
+}
+
+#endif // VU_SIMD_X86
+
+/**
+ * Dispatcher
+ */
+
+typedef bool (*fn_equal_ignore_case_t)(const byte* left, const byte* right, const size_t length);
+typedef size_t (*fn_find_ignore_case_t)(const byte* ptr, const size_t size, const byte* needle, const size_t length);
+
+static fn_equal_ignore_case_t select_equal_ignore_case_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return equal_ignore_case_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return equal_ignore_case_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return equal_ignore_case_scalar;
+}
+
+static fn_find_ignore_case_t select_find_ignore_case_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return find_ignore_case_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return find_ignore_case_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return find_ignore_case_scalar;
+}
+
+bool equal_ignore_case_A(const char* left, const char* right, const size_t length)
+{
+  static const fn_equal_ignore_case_t fn = select_equal_ignore_case_kernel();
+
+  return fn(reinterpret_cast<const byte*>(left), reinterpret_cast<const byte*>(right), length);
+}
+
+size_t find_ignore_case_A(const char* ptr, const size_t size, const char* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  if (length == 0)
+  {
+    return 0;
+  }
+
+  static const fn_find_ignore_case_t fn = select_find_ignore_case_kernel();
+
+  return fn(reinterpret_cast<const byte*>(ptr), size, reinterpret_cast<const byte*>(needle), length);
+}
+
+/**
+ * Unicode
+ * The BMP characters are folded by a table of the simple lowercase mappings of the user default locale,
+ * it is built once on the first use by LCMapString. The surrogates are not mapped so the characters
+ * of the supplementary planes are compared exactly.
+ */
+
+static const size_t FOLD_TABLE_SIZE = 0x10000;
+
+static wchar g_fold_table[FOLD_TABLE_SIZE];
+static std::once_flag g_fold_table_once;
+
+static void map_fold_table(const size_t first, const size_t last)
+{
+  const int n = int(last - first);
+
+  std::vector<wchar> lower(n);
+
+  const int result = LCMapStringW(
+    LOCALE_USER_DEFAULT, LCMAP_LOWERCASE | LCMAP_LINGUISTIC_CASING, &g_fold_table[first], n, lower.data(), n);
+
+  // the lowercase mappings are one to one, otherwise the range is kept unfolded
+
+  if (result == n)
+  {
+    memcpy(&g_fold_table[first], lower.data(), n * sizeof(wchar));
+  }
+}
+
+static void initialize_fold_table()
+{
+  for (size_t i = 0; i < FOLD_TABLE_SIZE; i++)
+  {
+    g_fold_table[i] = wchar(i);
+  }
+
+  map_fold_table(0x0000, 0xD800);
+  map_fold_table(0xE000, FOLD_TABLE_SIZE);
+}
+
+static inline wchar fold_unicode(const wchar c)
+{
+  return size_t(c) < FOLD_TABLE_SIZE ? g_fold_table[size_t(c)] : c;
+}
+
+static bool equal_fold_unicode(const wchar* left, const wchar* right, const size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    if (left[i] != right[i] && fold_unicode(left[i]) != fold_unicode(right[i]))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool equal_ignore_case_W(const wchar* left, const wchar* right, const size_t length)
+{
+  std::call_once(g_fold_table_once, initialize_fold_table);
+
+  return equal_fold_unicode(left, right, length);
+}
+
+size_t find_ignore_case_W(const wchar* ptr, const size_t size, const wchar* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  if (length == 0)
+  {
+    return 0;
+  }
+
+  std::call_once(g_fold_table_once, initialize_fold_table);
+
+  const wchar first = fold_unicode(needle[0]);
+
+  for (size_t i = 0; i + length <= size; i++)
+  {
+    if (fold_unicode(ptr[i]) == first && equal_fold_unicode(ptr + i + 1, needle + 1, length - 1))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+} // namespace vu
@@ -0,0 +1,29 @@
+/**
+ * @file   casefold.h
+ * @author Vic P.
+ * @brief  Header for Case Folding
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+/**
+ * Compare two strings of the same length case-insensitively.
+ * The narrow strings are folded as ASCII, the wide strings are folded by the simple lowercase mapping
+ * of the user default locale (the characters of the supplementary planes are compared exactly).
+ */
+bool equal_ignore_case_A(const char* left, const char* right, const size_t length);
+bool equal_ignore_case_W(const wchar* left, const wchar* right, const size_t length);
+
+/**
+ * Find the first occurrence of a needle in a string case-insensitively.
+ * @return The offset of the first occurrence or -1 if not found.
+ */
+size_t find_ignore_case_A(const char* ptr, const size_t size, const char* needle, const size_t length);
+size_t find_ignore_case_W(const wchar* ptr, const size_t size, const wchar* needle, const size_t length);
+
+} // namespace vu
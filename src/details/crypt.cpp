@@ -123,10 +123,20 @@ std::wstring crypt_md5_text_W(const std::wstring& text)
 
 std::string crypt_md5_buffer_A(const std::vector<byte>& data)
 {
-  return md5(data.data(), data.size());
+  return crypt_md5_buffer_A(BufferView(data));
 }
 
 std::wstring crypt_md5_buffer_W(const std::vector<byte>& data)
+{
+  return crypt_md5_buffer_W(BufferView(data));
+}
+
+std::string crypt_md5_buffer_A(const BufferView& data)
+{
+  return md5(data.get_ptr(), data.get_size());
+}
+
+std::wstring crypt_md5_buffer_W(const BufferView& data)
 {
   const auto result = crypt_md5_buffer_A(data);
   return to_string_W(result);
@@ -169,6 +179,12 @@ std::wstring crypt_md5_file_W(const std::wstring& file_path)
 
 uint64 crypt_crc_buffer(const std::vector<byte>& data,
   uint8_t bits, uint64 poly, uint64 init, bool ref_in, bool ref_out, uint64 xor_out, uint64 check)
+{
+  return crypt_crc_buffer(BufferView(data), bits, poly, init, ref_in, ref_out, xor_out, check);
+}
+
+uint64 crypt_crc_buffer(const BufferView& data,
+  uint8_t bits, uint64 poly, uint64 init, bool ref_in, bool ref_out, uint64 xor_out, uint64 check)
 {
   static std::vector<AbstractProxy_CRC_t*> g_crc_list;
   if (g_crc_list.empty())
@@ -192,7 +208,7 @@ uint64 crypt_crc_buffer(const std::vector<byte>& data,
         ptr_crc->xor_out == xor_out &&
         ptr_crc->check   == check)
     {
-      result = ptr_crc->get_crc(data.data(), data.size());
+      result = ptr_crc->get_crc(data.get_ptr_bytes(), data.get_size());
       break;
     }
   }
@@ -201,34 +217,39 @@ uint64 crypt_crc_buffer(const std::vector<byte>& data,
 }
 
 uint64 crypt_crc_buffer(const std::vector<byte>& data, const crypt_bits bits)
+{
+  return crypt_crc_buffer(BufferView(data), bits);
+}
+
+uint64 crypt_crc_buffer(const BufferView& data, const crypt_bits bits)
 {
   switch (bits)
   {
   case crypt_bits::_8:
     {
       CRC_t<8, 0x07, 0x00, false, false, 0x00> crc;
-      return crc.get_crc(data.data(), data.size());
+      return crc.get_crc(data.get_ptr_bytes(), data.get_size());
     }
     break;
 
   case crypt_bits::_16:
     {
       CRC_t<16, 0x8005, 0x0000, true, true, 0x0000> crc;
-      return crc.get_crc(data.data(), data.size());
+      return crc.get_crc(data.get_ptr_bytes(), data.get_size());
     }
     break;
 
   case crypt_bits::_32:
     {
       CRC_t<32, 0x04C11DB7, 0xFFFFFFFF, true, true, 0xFFFFFFFF> crc;
-      return crc.get_crc(data.data(), data.size());
+      return crc.get_crc(data.get_ptr_bytes(), data.get_size());
     }
     break;
 
   case crypt_bits::_64:
     {
       CRC_t<64, 0x42F0E1EBA9EA3693, 0x0000000000000000, false, false, 0x0000000000000000> crc;
-      return crc.get_crc(data.data(), data.size());
+      return crc.get_crc(data.get_ptr_bytes(), data.get_size());
     }
     break;
 
@@ -244,8 +265,7 @@ uint64 crypt_crc_buffer(const std::vector<byte>& data, const crypt_bits bits)
 
 uint64 crypt_crc_text_A(const std::string& text, const crypt_bits bits)
 {
-  std::vector<byte> data(text.cbegin(), text.cend());
-  return crypt_crc_buffer(data, bits);
+  return crypt_crc_buffer(BufferView(text.data(), text.size()), bits);
 }
 
 uint64 crypt_crc_text_W(const std::wstring& text, const crypt_bits bits)
@@ -279,10 +299,8 @@ uint64 crypt_crc_file_W(const std::wstring& file_path, const crypt_bits bits)
 
 std::string crypt_sha_text_A(const std::string& text, const sha_version version, const crypt_bits bits)
 {
-  std::vector<byte> data(text.cbegin(), text.cend());
-
   std::vector<byte> hash;
-  crypt_sha_buffer(data, version, bits, hash);
+  crypt_sha_buffer(BufferView(text.data(), text.size()), version, bits, hash);
 
   std::string result = to_hex_string_A(hash.data(), hash.size());
   return result;
@@ -324,6 +342,15 @@ void crypt_sha_buffer(
   const sha_version version,
   const crypt_bits bits,
   std::vector<byte>& hash)
+{
+  crypt_sha_buffer(BufferView(data), version, bits, hash);
+}
+
+void crypt_sha_buffer(
+  const BufferView& data,
+  const sha_version version,
+  const crypt_bits bits,
+  std::vector<byte>& hash)
 {
   bool valid_args = false;
 
@@ -344,44 +371,44 @@ void crypt_sha_buffer(
 
   if (version == sha_version::_1)
   {
-    sha_1::sha1(data.data(), data.size(), pstr);
+    sha_1::sha1(data.get_ptr(), data.get_size(), pstr);
   }
   else if (version == sha_version::_2)
   {
     if (bits == crypt_bits::_224)
     {
-      sha_2_224::sha2(data.data(), data.size(), pstr);
+      sha_2_224::sha2(data.get_ptr(), data.get_size(), pstr);
     }
     else if (bits == crypt_bits::_256)
     {
-      sha_2_256::sha2(data.data(), data.size(), pstr);
+      sha_2_256::sha2(data.get_ptr(), data.get_size(), pstr);
     }
     else if (bits == crypt_bits::_384)
     {
-      sha_2_384::sha2(data.data(), data.size(), pstr);
+      sha_2_384::sha2(data.get_ptr(), data.get_size(), pstr);
     }
     else if (bits == crypt_bits::_512)
     {
-      sha_2_512::sha2(data.data(), data.size(), pstr);
+      sha_2_512::sha2(data.get_ptr(), data.get_size(), pstr);
     }
   }
   else if (version == sha_version::_3)
   {
     if (bits == crypt_bits::_224)
     {
-      sha_3_224::sha3(data.data(), data.size(), pstr);
+      sha_3_224::sha3(data.get_ptr(), data.get_size(), pstr);
     }
     else if (bits == crypt_bits::_256)
     {
-      sha_3_256::sha3(data.data(), data.size(), pstr);
+      sha_3_256::sha3(data.get_ptr(), data.get_size(), pstr);
     }
     else if (bits == crypt_bits::_384)
     {
-      sha_3_384::sha3(data.data(), data.size(), pstr);
+      sha_3_384::sha3(data.get_ptr(), data.get_size(), pstr);
     }
     else if (bits == crypt_bits::_512)
     {
-      sha_3_512::sha3(data.data(), data.size(), pstr);
+      sha_3_512::sha3(data.get_ptr(), data.get_size(), pstr);
     }
   }
   else
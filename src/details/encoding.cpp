@@ -0,0 +1,327 @@
+/**
+ * @file   encoding.cpp
+ * @author Vic P.
+ * @brief  Implementation for Encoding Detection
+ */
+
+#include "Vutils.h"
+#include "utf.h"
+#include "simd.h"
+
+namespace vu
+{
+
+/**
+ * Null Bytes
+ * The null bytes are counted separately at the even and the odd offsets. The SIMD kernels accumulate
+ * the compare results in the byte lanes and sum the lanes before they can overflow.
+ */
+
+static void count_nul_bytes_scalar(const byte* ptr, const size_t size, size_t& even, size_t& odd)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (ptr[i] == 0)
+    {
+      (i & 1) == 0 ? even++ : odd++;
+    }
+  }
+}
+
+#ifdef VU_SIMD_X86
+
+static const size_t MAX_LANE_BLOCKS = 255;
+
+VU_TARGET_SSE2 static inline size_t sum_lanes_sse2(const __m128i sums)
+{
+  return size_t(_mm_cvtsi128_si32(sums)) + size_t(_mm_extract_epi16(sums, 4));
+}
+
+VU_TARGET_SSE2 static void count_nul_bytes_sse2(const byte* ptr, const size_t size, size_t& even, size_t& odd)
+{
+  const auto zero = _mm_setzero_si128();
+  const auto low  = _mm_set1_epi16(0x00FF);
+
+  size_t i = 0;
+
+  while (i + 16 <= size)
+  {
+    auto counts = _mm_setzero_si128();
+
+    for (size_t n = 0; n < MAX_LANE_BLOCKS && i + 16 <= size; n++, i += 16)
+    {
+      const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+      counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(v, zero));
+    }
+
+    even += sum_lanes_sse2(_mm_sad_epu8(_mm_and_si128(counts, low), zero));
+    odd  += sum_lanes_sse2(_mm_sad_epu8(_mm_srli_epi16(counts, 8), zero));
+  }
+
+  count_nul_bytes_scalar(ptr + i, size - i, even, odd);
+}
+
+VU_TARGET_AVX2 static inline size_t sum_lanes_avx2(const __m256i sums)
+{
+  const auto v = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+  return size_t(_mm_cvtsi128_si32(v)) + size_t(_mm_extract_epi16(v, 4));
+}
+
+VU_TARGET_AVX2 static void count_nul_bytes_avx2(const byte* ptr, const size_t size, size_t& even, size_t& odd)
+{
+  const auto zero = _mm256_setzero_si256();
+  const auto low  = _mm256_set1_epi16(0x00FF);
+
+  size_t i = 0;
+
+  while (i + 32 <= size)
+  {
+    auto counts = _mm256_setzero_si256();
+
+    for (size_t n = 0; n < MAX_LANE_BLOCKS && i + 32 <= size; n++, i += 32)
+    {
+      const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i));
+      counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(v, zero));
+    }
+
+    even += sum_lanes_avx2(_mm256_sad_epu8(_mm256_and_si256(counts, low), zero));
+    odd  += sum_lanes_avx2(_mm256_sad_epu8(_mm256_srli_epi16(counts, 8), zero));
+  }
+
+  count_nul_bytes_sse2(ptr + i, size - i, even, odd);
+}
+
+#endif // VU_SIMD_X86
+
+typedef void (*fn_count_nul_bytes_t)(const byte* ptr, const size_t size, size_t& even, size_t& odd);
+
+static fn_count_nul_bytes_t select_count_nul_bytes_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return count_nul_bytes_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return count_nul_bytes_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return count_nul_bytes_scalar;
+}
+
+static void count_nul_bytes(const byte* ptr, const size_t size, size_t& even, size_t& odd)
+{
+  static const fn_count_nul_bytes_t fn = select_count_nul_bytes_kernel();
+  fn(ptr, size, even, odd);
+}
+
+/**
+ * Detection
+ * A BOM is certain. Without a BOM, the text of UTF-16 has a null byte in the high byte of the code units
+ * of the ASCII and Latin-1 characters, so the null bytes are mostly at the odd offsets for LE and at the
+ * even offsets for BE, the text of 8-bit has no null byte. The rest is ANSI/UTF-8, it is validated as
+ * UTF-8 and the null bytes lower its confidence, the invalid UTF-8 with the null bytes is binary.
+ */
+
+static const float UTF16_MIN_NUL_RATIO = 0.05F;  // the code units that have a null high byte
+static const float UTF16_MAX_NUL_SKEW  = 0.125F; // the null low bytes relative to the null high bytes
+
+static size_t detect_bom(const byte* p, const size_t size, encoding_type& type)
+{
+  if (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+  {
+    type = encoding_type::ET_UTF8_BOM;
+    return 3;
+  }
+
+  if (size >= 4 && p[0] == 0xFF && p[1] == 0xFE && p[2] == 0x00 && p[3] == 0x00)
+  {
+    type = encoding_type::ET_UTF32_LE_BOM;
+    return 4;
+  }
+
+  if (size >= 4 && p[0] == 0x00 && p[1] == 0x00 && p[2] == 0xFE && p[3] == 0xFF)
+  {
+    type = encoding_type::ET_UTF32_BE_BOM;
+    return 4;
+  }
+
+  if (size >= 2 && p[0] == 0xFF && p[1] == 0xFE)
+  {
+    type = encoding_type::ET_UTF16_LE_BOM;
+    return 2;
+  }
+
+  if (size >= 2 && p[0] == 0xFE && p[1] == 0xFF)
+  {
+    type = encoding_type::ET_UTF16_BE_BOM;
+    return 2;
+  }
+
+  return 0;
+}
+
+/**
+ * The size without the last sequence if the end of the sample cuts it.
+ */
+static size_t trim_truncated_sequence(const byte* ptr, const size_t size)
+{
+  size_t i = size, n_continuations = 0;
+
+  while (i > 0 && n_continuations < 3 && (ptr[i - 1] & 0xC0) == 0x80)
+  {
+    i--, n_continuations++;
+  }
+
+  if (i == 0)
+  {
+    return size;
+  }
+
+  const byte c = ptr[i - 1];
+
+  size_t length = 1;
+
+  if ((c & 0xE0) == 0xC0)
+  {
+    length = 2;
+  }
+  else if ((c & 0xF0) == 0xE0)
+  {
+    length = 3;
+  }
+  else if ((c & 0xF8) == 0xF0)
+  {
+    length = 4;
+  }
+
+  return length > n_continuations + 1 ? i - 1 : size;
+}
+
+/**
+ * Detect the encoding by the first `sample_size` bytes of the data that has `size` bytes.
+ */
+static EncodingInfo detect(const byte* ptr, const size_t size, const size_t sample_size)
+{
+  EncodingInfo result;
+  result.type = encoding_type::ET_UNKNOWN;
+  result.confidence = 0.F;
+  result.bom_size = 0;
+  result.sample_size = 0;
+  result.valid_utf8 = false;
+
+  if (ptr == nullptr || size == 0)
+  {
+    return result;
+  }
+
+  result.bom_size = detect_bom(ptr, sample_size, result.type);
+  result.sample_size = sample_size;
+
+  if (result.bom_size != 0)
+  {
+    result.confidence = 1.F;
+
+    if (result.type == encoding_type::ET_UTF8_BOM)
+    {
+      const auto text = ptr + result.bom_size;
+      const size_t length = sample_size - result.bom_size;
+      result.valid_utf8 = validate_utf8(
+        reinterpret_cast<const char*>(text), sample_size < size ? trim_truncated_sequence(text, length) : length);
+    }
+
+    return result;
+  }
+
+  if (sample_size == 0)
+  {
+    return result;
+  }
+
+  const size_t n_units = sample_size / 2;
+
+  size_t n_even = 0, n_odd = 0;
+  count_nul_bytes(ptr, 2 * n_units, n_even, n_odd);
+
+  // UTF-16
+
+  if (n_units != 0)
+  {
+    const bool le = n_odd >= n_even;
+    const float high = float(le ? n_odd : n_even) / n_units;
+    const float low  = float(le ? n_even : n_odd) / n_units;
+
+    if (high >= UTF16_MIN_NUL_RATIO && low <= high * UTF16_MAX_NUL_SKEW)
+    {
+      result.type = le ? encoding_type::ET_UTF16_LE : encoding_type::ET_UTF16_BE;
+      result.confidence = (1.F - low / high) * (high < 0.5F ? 0.5F + high : 1.F);
+      return result;
+    }
+  }
+
+  // ANSI/UTF-8
+
+  if (sample_size % 2 != 0 && ptr[sample_size - 1] == 0)
+  {
+    n_even++;
+  }
+
+  const size_t n_nuls = n_even + n_odd;
+
+  result.valid_utf8 = validate_utf8(
+    reinterpret_cast<const char*>(ptr), sample_size < size ? trim_truncated_sequence(ptr, sample_size) : sample_size);
+
+  if (!result.valid_utf8 && n_nuls != 0)
+  {
+    return result;
+  }
+
+  result.type = encoding_type::ET_UTF8;
+  result.confidence = (result.valid_utf8 ? 1.F : 0.5F) * (1.F - float(n_nuls) / sample_size);
+
+  return result;
+}
+
+EncodingInfo vuapi detect_encoding(const void* data, const size_t size, const size_t max_sample_size)
+{
+  return detect(static_cast<const byte*>(data), size, size < max_sample_size ? size : max_sample_size);
+}
+
+encoding_type vuapi determine_encoding_type(const void* data, const size_t size)
+{
+  return detect_encoding(data, size).type;
+}
+
+template <class file_system_t, class std_string_t>
+EncodingInfo detect_encoding_in_file_T(const std_string_t& file_path, const size_t max_sample_size)
+{
+  file_system_t file(file_path, fs_mode::FM_OPENEXISTING, fs_generic::FG_READ, fs_share::FS_READ);
+
+  const size_t file_size = file.ready() ? size_t(file.get_file_size()) : 0;
+  const size_t sample_size = file_size < max_sample_size ? file_size : max_sample_size;
+
+  std::vector<byte> sample(sample_size);
+  if (sample_size != 0 && !file.read(sample.data(), ulong(sample_size)))
+  {
+    return detect(nullptr, 0, 0);
+  }
+
+  return detect(sample.data(), file_size, sample_size);
+}
+
+EncodingInfo vuapi detect_encoding_in_file_A(const std::string& file_path, const size_t max_sample_size)
+{
+  return detect_encoding_in_file_T<FileSystemA>(file_path, max_sample_size);
+}
+
+EncodingInfo vuapi detect_encoding_in_file_W(const std::wstring& file_path, const size_t max_sample_size)
+{
+  return detect_encoding_in_file_T<FileSystemW>(file_path, max_sample_size);
+}
+
+} // namespace vu
@@ -42,6 +42,14 @@ void* vuapi FileMappingX::view(
     return nullptr;
   }
 
+  // unmap the previous view so the view could be slid over the file
+
+  if (m_ptr_data != nullptr)
+  {
+    UnmapViewOfFile(m_ptr_data);
+    m_ptr_data = nullptr;
+  }
+
   m_ptr_data = MapViewOfFile(
     m_map_handle,
     the_desired_access,
@@ -90,6 +98,21 @@ ulong vuapi FileMappingX::get_file_size()
   return result;
 }
 
+uint64 vuapi FileMappingX::get_file_size_ex()
+{
+  if (!this->valid(m_file_handle))
+  {
+    return 0;
+  }
+
+  LARGE_INTEGER result = { 0 };
+  ::GetFileSizeEx(m_file_handle, &result);
+
+  m_last_error_code = GetLastError();
+
+  return uint64(result.QuadPart);
+}
+
 /**
  * FileMappingA
  */
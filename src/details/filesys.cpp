@@ -93,6 +93,37 @@ bool vuapi FileSystemX::write(const void* ptr_buffer, ulong size)
   return true;
 }
 
+bool vuapi FileSystemX::write(const BufferChain& chain)
+{
+  // the segments are written one by one without flattening them,
+  // WriteFileGather is not used since it requires the unbuffered and page-aligned writes
+
+  ulong wrote_size = 0;
+
+  for (size_t i = 0; i < chain.count(); i++)
+  {
+    const auto view = chain.at(i);
+
+    for (size_t offset = 0; offset < view.get_size();)
+    {
+      const size_t n = view.get_size() - offset < MAXDWORD ? view.get_size() - offset : MAXDWORD;
+
+      if (!this->write(view.get_ptr_bytes() + offset, ulong(n)) || m_wrote_size == 0)
+      {
+        m_wrote_size = wrote_size;
+        return false;
+      }
+
+      offset += m_wrote_size;
+      wrote_size += m_wrote_size;
+    }
+  }
+
+  m_wrote_size = wrote_size;
+
+  return true;
+}
+
 bool vuapi FileSystemX::seek(ulong offset, fs_position_at flags)
 {
   if (!this->valid(m_handle))
@@ -158,7 +189,7 @@ bool vuapi FileSystemX::close()
   return true;
 }
 
-const Buffer vuapi FileSystemX::read_as_buffer()
+Buffer vuapi FileSystemX::read_as_buffer()
 {
   Buffer buffer(0);
 
@@ -168,9 +199,12 @@ const Buffer vuapi FileSystemX::read_as_buffer()
     return buffer;
   }
 
-  buffer.resize(size);
+  buffer.resize(size, false); // overwritten by the reading
 
-  this->read(0, buffer.get_ptr(), size, fs_position_at::PA_BEGIN);
+  if (!this->read(0, buffer.get_ptr(), size, fs_position_at::PA_BEGIN))
+  {
+    buffer.reset();
+  }
 
   return buffer;
 }
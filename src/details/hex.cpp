@@ -0,0 +1,373 @@
+/**
+ * @file   hex.cpp
+ * @author Vic P.
+ * @brief  Implementation for Hex Encoding
+ */
+
+#include "hex.h"
+#include "simd.h"
+
+namespace vu
+{
+
+static const char HEX_DIGITS_LOWER[] = "0123456789abcdef";
+static const char HEX_DIGITS_UPPER[] = "0123456789ABCDEF";
+
+static const byte HEX_INVALID = 0xFF;
+static const byte HEX_SPACE   = 0xFE;
+
+/**
+ * The values of the hex digits, the whitespaces and the other characters are marked.
+ */
+
+struct HexTable
+{
+  byte values[256];
+
+  HexTable()
+  {
+    memset(values, HEX_INVALID, sizeof(values));
+
+    for (int i = 0; i < 10; i++)
+    {
+      values['0' + i] = byte(i);
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+      values['a' + i] = byte(10 + i);
+      values['A' + i] = byte(10 + i);
+    }
+
+    for (auto c : " \t\n\r\f\v")
+    {
+      if (c != '\0') values[byte(c)] = HEX_SPACE;
+    }
+  }
+};
+
+static const HexTable g_hex_table;
+
+/**
+ * Scalar
+ */
+
+static void encode_hex_scalar(const byte* ptr, const size_t size, char* text, const bool upper)
+{
+  const char* digits = upper ? HEX_DIGITS_UPPER : HEX_DIGITS_LOWER;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    text[2 * i] = digits[ptr[i] >> 4];
+    text[2 * i + 1] = digits[ptr[i] & 0x0F];
+  }
+}
+
+#ifdef VU_SIMD_X86
+
+/**
+ * SSSE3
+ * The nibbles are mapped to their digits by PSHUFB, and the digits are mapped back to their nibbles by
+ * the range compares then the pairs are combined by PMADDUBSW (high * 16 + low).
+ */
+
+VU_TARGET_SSSE3 static void encode_hex_ssse3(const byte* ptr, const size_t size, char* text, const bool upper)
+{
+  const auto digits = _mm_loadu_si128(
+    reinterpret_cast<const __m128i*>(upper ? HEX_DIGITS_UPPER : HEX_DIGITS_LOWER));
+  const auto mask = _mm_set1_epi8(0x0F);
+
+  size_t i = 0;
+
+  for (; i + 16 <= size; i += 16)
+  {
+    const auto v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+    const auto hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+    const auto lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(text + 2 * i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(text + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+
+  encode_hex_scalar(ptr + i, size - i, text + 2 * i, upper);
+}
+
+VU_TARGET_SSSE3 static inline __m128i hex_nibbles_ssse3(const __m128i c, __m128i& valid)
+{
+  const auto lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+
+  const auto is_digit = _mm_cmplt_epi8(
+    _mm_add_epi8(c, _mm_set1_epi8(char(0x80 - '0'))), _mm_set1_epi8(char(-0x80 + 10)));
+  const auto is_alpha = _mm_cmplt_epi8(
+    _mm_add_epi8(lower, _mm_set1_epi8(char(0x80 - 'a'))), _mm_set1_epi8(char(-0x80 + 6)));
+
+  valid = _mm_and_si128(valid, _mm_or_si128(is_digit, is_alpha));
+
+  const auto digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  const auto alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+
+  return _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_alpha, alpha));
+}
+
+VU_TARGET_SSSE3 static size_t decode_hex_ssse3(const char* text, const size_t length, byte* buffer)
+{
+  const auto weights = _mm_set1_epi16(0x0110); // high * 16 + low * 1
+
+  size_t i = 0;
+
+  for (; i + 32 <= length; i += 32)
+  {
+    auto valid = _mm_set1_epi8(char(0xFF));
+    const auto n1 = hex_nibbles_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), valid);
+    const auto n2 = hex_nibbles_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 16)), valid);
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+    {
+      break;
+    }
+
+    const auto v = _mm_packus_epi16(_mm_maddubs_epi16(n1, weights), _mm_maddubs_epi16(n2, weights));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i / 2), v);
+  }
+
+  return i;
+}
+
+/**
+ * AVX2
+ * The same as SSSE3 but the instructions work on the 128-bit lanes, so the lanes are reordered.
+ */
+
+VU_TARGET_AVX2 static void encode_hex_avx2(const byte* ptr, const size_t size, char* text, const bool upper)
+{
+  const auto digits = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(upper ? HEX_DIGITS_UPPER : HEX_DIGITS_LOWER)));
+  const auto mask = _mm256_set1_epi8(0x0F);
+
+  size_t i = 0;
+
+  for (; i + 32 <= size; i += 32)
+  {
+    const auto v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i));
+    const auto hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+    const auto lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, mask));
+    const auto t1 = _mm256_unpacklo_epi8(hi, lo); // bytes 0..7 | 16..23
+    const auto t2 = _mm256_unpackhi_epi8(hi, lo); // bytes 8..15 | 24..31
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(text + 2 * i), _mm256_permute2x128_si256(t1, t2, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(text + 2 * i + 32), _mm256_permute2x128_si256(t1, t2, 0x31));
+  }
+
+  encode_hex_ssse3(ptr + i, size - i, text + 2 * i, upper);
+}
+
+VU_TARGET_AVX2 static inline __m256i hex_nibbles_avx2(const __m256i c, __m256i& valid)
+{
+  const auto lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+
+  const auto is_digit = _mm256_cmpgt_epi8(
+    _mm256_set1_epi8(char(-0x80 + 10)), _mm256_add_epi8(c, _mm256_set1_epi8(char(0x80 - '0'))));
+  const auto is_alpha = _mm256_cmpgt_epi8(
+    _mm256_set1_epi8(char(-0x80 + 6)), _mm256_add_epi8(lower, _mm256_set1_epi8(char(0x80 - 'a'))));
+
+  valid = _mm256_and_si256(valid, _mm256_or_si256(is_digit, is_alpha));
+
+  const auto digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+  const auto alpha = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+
+  return _mm256_or_si256(_mm256_and_si256(is_digit, digit), _mm256_and_si256(is_alpha, alpha));
+}
+
+VU_TARGET_AVX2 static size_t decode_hex_avx2(const char* text, const size_t length, byte* buffer)
+{
+  const auto weights = _mm256_set1_epi16(0x0110);
+
+  size_t i = 0;
+
+  for (; i + 64 <= length; i += 64)
+  {
+    auto valid = _mm256_set1_epi8(char(0xFF));
+    const auto n1 = hex_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)), valid);
+    const auto n2 = hex_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + 32)), valid);
+    if (uint32(_mm256_movemask_epi8(valid)) != 0xFFFFFFFF)
+    {
+      break;
+    }
+
+    const auto v = _mm256_packus_epi16(_mm256_maddubs_epi16(n1, weights), _mm256_maddubs_epi16(n2, weights));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + i / 2), _mm256_permute4x64_epi64(v, 0xD8));
+  }
+
+  return i + decode_hex_ssse3(text + i, length - i, buffer + i / 2);
+}
+
+#endif // VU_SIMD_X86
+
+/**
+ * Dispatcher
+ */
+
+typedef void (*fn_encode_hex_t)(const byte* ptr, const size_t size, char* text, const bool upper);
+typedef size_t (*fn_decode_hex_t)(const char* text, const size_t length, byte* buffer);
+
+static fn_encode_hex_t select_encode_hex_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return encode_hex_avx2;
+  }
+
+  if (features.ssse3)
+  {
+    return encode_hex_ssse3;
+  }
+  #endif // VU_SIMD_X86
+
+  return encode_hex_scalar;
+}
+
+static fn_decode_hex_t select_decode_hex_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return decode_hex_avx2;
+  }
+
+  if (features.ssse3)
+  {
+    return decode_hex_ssse3;
+  }
+  #endif // VU_SIMD_X86
+
+  return nullptr; // the digits are decoded one by one
+}
+
+void encode_hex(const byte* ptr, const size_t size, char* text, const bool upper, const char separator)
+{
+  static const fn_encode_hex_t fn = select_encode_hex_kernel();
+
+  if (separator == 0)
+  {
+    fn(ptr, size, text, upper);
+    return;
+  }
+
+  const char* digits = upper ? HEX_DIGITS_UPPER : HEX_DIGITS_LOWER;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    if (i != 0)
+    {
+      *text++ = separator;
+    }
+
+    *text++ = digits[ptr[i] >> 4];
+    *text++ = digits[ptr[i] & 0x0F];
+  }
+}
+
+void encode_hex(const byte* ptr, const size_t size, wchar* text, const bool upper, const wchar separator)
+{
+  // the bytes are encoded chunk by chunk to a narrow text then widened, the separators are marked by spaces
+
+  const size_t CHUNK_SIZE = 256;
+
+  char chunk[3 * CHUNK_SIZE];
+
+  for (size_t i = 0; i < size; i += CHUNK_SIZE)
+  {
+    const size_t n = size - i < CHUNK_SIZE ? size - i : CHUNK_SIZE;
+
+    if (i != 0 && separator != 0)
+    {
+      *text++ = separator;
+    }
+
+    encode_hex(ptr + i, n, chunk, upper, separator != 0 ? ' ' : 0);
+
+    const size_t length = hex_text_length(n, separator != 0);
+
+    for (size_t j = 0; j < length; j++)
+    {
+      *text++ = chunk[j] == ' ' ? separator : wchar(chunk[j]);
+    }
+  }
+}
+
+template <typename T>
+static bool decode_hex_T(
+  const T* text, const size_t length, byte* buffer, size_t& size, size_t (*fn)(const T*, const size_t, byte*))
+{
+  const size_t capacity = size;
+
+  size = 0;
+
+  int high = -1;    // The pending high nibble
+  size_t retry = 0; // The offset to retry the kernel after it stopped at a non-digit
+
+  for (size_t i = 0; i < length;)
+  {
+    // the runs of the digits are decoded by the kernel, the others are decoded one by one
+
+    if (fn != nullptr && high < 0 && i >= retry)
+    {
+      const size_t n_max = length - i < 2 * (capacity - size) ? length - i : 2 * (capacity - size);
+      const size_t n = fn(text + i, n_max, buffer + size);
+
+      i += n;
+      size += n / 2;
+      retry = i + 64;
+
+      if (i >= length)
+      {
+        break;
+      }
+    }
+
+    const auto c = text[i++];
+    const byte v = uint32(c) < 256 ? g_hex_table.values[uint32(c)] : HEX_INVALID;
+
+    if (v == HEX_SPACE)
+    {
+      continue;
+    }
+
+    if (v == HEX_INVALID)
+    {
+      return false;
+    }
+
+    if (high < 0)
+    {
+      high = v;
+      continue;
+    }
+
+    if (size >= capacity)
+    {
+      return false;
+    }
+
+    buffer[size++] = byte((high << 4) | v);
+    high = -1;
+  }
+
+  return high < 0;
+}
+
+bool decode_hex(const char* text, const size_t length, byte* buffer, size_t& size)
+{
+  static const fn_decode_hex_t fn = select_decode_hex_kernel();
+
+  return decode_hex_T<char>(text, length, buffer, size, fn);
+}
+
+bool decode_hex(const wchar* text, const size_t length, byte* buffer, size_t& size)
+{
+  return decode_hex_T<wchar>(text, length, buffer, size, nullptr);
+}
+
+} // namespace vu
@@ -0,0 +1,36 @@
+/**
+ * @file   hex.h
+ * @author Vic P.
+ * @brief  Header for Hex Encoding
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+/**
+ * The length of the hex text of the bytes, a separator is counted between each two bytes if separated.
+ */
+inline size_t hex_text_length(const size_t size, const bool separated)
+{
+  return size == 0 ? 0 : 2 * size + (separated ? size - 1 : 0);
+}
+
+/**
+ * Encode the bytes to the hex text, the text must have the room for `hex_text_length` characters.
+ */
+void encode_hex(const byte* ptr, const size_t size, char*  text, const bool upper, const char  separator);
+void encode_hex(const byte* ptr, const size_t size, wchar* text, const bool upper, const wchar separator);
+
+/**
+ * Decode the hex text to the bytes, the whitespaces between the digits are skipped.
+ * @param[in,out] size The size of the buffer, then the number of the decoded bytes.
+ * @return false if the text has a non-hex character, an odd number of digits or the buffer is too small.
+ */
+bool decode_hex(const char*  text, const size_t length, byte* buffer, size_t& size);
+bool decode_hex(const wchar* text, const size_t length, byte* buffer, size_t& size);
+
+} // namespace vu
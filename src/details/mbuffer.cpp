@@ -5,30 +5,217 @@
  */
 
 #include "Vutils.h"
+#include "pattern.h"
+#include "search.h"
 
 namespace vu
 {
 
-Buffer::Buffer() : m_ptr(nullptr), m_size(0)
+/**
+ * BufferView
+ */
+
+BufferView::BufferView() : m_ptr(nullptr), m_size(0)
+{
+}
+
+BufferView::BufferView(const void* ptr, const size_t size)
+  : m_ptr(static_cast<const byte*>(ptr)), m_size(ptr != nullptr ? size : 0)
+{
+}
+
+BufferView::BufferView(const Buffer& buffer) : m_ptr(buffer.get_ptr_bytes()), m_size(buffer.get_size())
+{
+}
+
+BufferView::BufferView(const std::vector<byte>& data) : m_ptr(data.data()), m_size(data.size())
+{
+}
+
+bool BufferView::operator==(const BufferView& right) const
+{
+  if (m_size != right.m_size)
+  {
+    return false;
+  }
+
+  return m_ptr == right.m_ptr || m_size == 0 || memcmp(m_ptr, right.m_ptr, m_size) == 0;
+}
+
+bool BufferView::operator!=(const BufferView& right) const
+{
+  return !(*this == right);
+}
+
+const byte& BufferView::operator[](const size_t offset) const
+{
+  if (m_ptr == nullptr)
+  {
+    throw std::runtime_error(static_cast<const char*>("invalid pointer"));
+  }
+
+  if (m_size == 0 || offset >= m_size)
+  {
+    throw std::out_of_range(static_cast<const char*>("invalid size or offset"));
+  }
+
+  return m_ptr[offset];
+}
+
+BufferView BufferView::operator()(intptr begin, intptr end) const
+{
+  return this->slice(begin, end);
+}
+
+const byte* BufferView::get_ptr_bytes() const
+{
+  return m_ptr;
+}
+
+const void* BufferView::get_ptr() const
+{
+  return m_ptr;
+}
+
+size_t BufferView::get_size() const
+{
+  return m_size;
+}
+
+bool BufferView::empty() const
+{
+  return m_ptr == nullptr || m_size == 0;
+}
+
+size_t BufferView::find(const void* ptr, const size_t size) const
+{
+  return find_bytes_first(m_ptr, m_size, static_cast<const byte*>(ptr), size);
+}
+
+size_t BufferView::rfind(const void* ptr, const size_t size) const
+{
+  return find_bytes_last(m_ptr, m_size, static_cast<const byte*>(ptr), size);
+}
+
+std::vector<size_t> BufferView::find_all(const void* ptr, const size_t size) const
+{
+  std::vector<size_t> result;
+  find_bytes_all(m_ptr, m_size, static_cast<const byte*>(ptr), size, &result);
+  return result;
+}
+
+size_t BufferView::count(const void* ptr, const size_t size) const
+{
+  return find_bytes_all(m_ptr, m_size, static_cast<const byte*>(ptr), size, nullptr);
+}
+
+bool BufferView::match(const void* ptr, const size_t size) const
+{
+  return this->find(ptr, size) != -1;
+}
+
+size_t BufferView::find(const Pattern& pattern) const
+{
+  return find_pattern_first(m_ptr, m_size, pattern);
+}
+
+bool BufferView::match(const Pattern& pattern) const
+{
+  return this->find(pattern) != -1;
+}
+
+BufferView BufferView::till(const void* ptr, const size_t size) const
+{
+  const size_t offset = this->find(ptr, size);
+  if (offset == -1)
+  {
+    return BufferView();
+  }
+
+  return BufferView(m_ptr, offset);
+}
+
+BufferView BufferView::slice(intptr begin, intptr end) const
+{
+  if (m_ptr == nullptr || m_size == 0)
+  {
+    return BufferView();
+  }
+
+  const intptr size = intptr(m_size);
+
+  if (begin < 0)
+  {
+    begin = size + begin;
+  }
+
+  if (end < 0)
+  {
+    end = size + end;
+  }
+
+  if (begin < 0 || end < 0 || begin > size || end > size || begin >= end)
+  {
+    return BufferView();
+  }
+
+  return BufferView(m_ptr + begin, size_t(end - begin));
+}
+
+bool BufferView::read(const size_t offset, void* ptr, const size_t size) const
+{
+  if (ptr == nullptr || offset > m_size || size > m_size - offset)
+  {
+    return false;
+  }
+
+  if (size != 0)
+  {
+    memcpy(ptr, m_ptr + offset, size);
+  }
+
+  return true;
+}
+
+std::string BufferView::to_string_A() const
+{
+  return std::string(reinterpret_cast<const char*>(m_ptr), m_size / sizeof(char));
+}
+
+std::wstring BufferView::to_string_W() const
+{
+  return std::wstring(reinterpret_cast<const wchar*>(m_ptr), m_size / sizeof(wchar));
+}
+
+/**
+ * Buffer
+ */
+
+Buffer::Buffer() : m_ptr(nullptr), m_size(0), m_capacity(0), m_pool(nullptr)
 {
   this->create(nullptr, 0);
 }
 
-Buffer::Buffer(const size_t size) : m_ptr(nullptr), m_size(0)
+Buffer::Buffer(const size_t size) : m_ptr(nullptr), m_size(0), m_capacity(0), m_pool(nullptr)
 {
   this->create(nullptr, size);
 }
 
-Buffer::Buffer(const void* ptr, const size_t size) : m_ptr(nullptr), m_size(0)
+Buffer::Buffer(const void* ptr, const size_t size) : m_ptr(nullptr), m_size(0), m_capacity(0), m_pool(nullptr)
 {
   this->replace(ptr, size);
 }
 
-Buffer::Buffer(const Buffer& right) : m_ptr(nullptr), m_size(0)
+Buffer::Buffer(const Buffer& right) : m_ptr(nullptr), m_size(0), m_capacity(0), m_pool(right.m_pool)
 {
   *this = right;
 }
 
+Buffer::Buffer(Buffer&& right) : m_ptr(nullptr), m_size(0), m_capacity(0), m_pool(nullptr)
+{
+  this->swap(right);
+}
+
 Buffer::~Buffer()
 {
   this->destroy();
@@ -36,15 +223,20 @@ Buffer::~Buffer()
 
 const Buffer& Buffer::operator=(const Buffer& right)
 {
-  if (*this != right)
+  if (this != &right)
   {
-    if (this->create(nullptr, right.m_size))
-    {
-      if (right.m_ptr != nullptr)
-      {
-        memcpy_s(m_ptr, m_size, right.m_ptr, right.m_size);
-      }
-    }
+    this->create(right.m_ptr, right.m_size);
+  }
+
+  return *this;
+}
+
+const Buffer& Buffer::operator=(Buffer&& right)
+{
+  if (this != &right)
+  {
+    this->destroy();
+    this->swap(right);
   }
 
   return *this;
@@ -80,32 +272,29 @@ byte& Buffer::operator[](const size_t offset)
   return static_cast<byte*>(m_ptr)[offset];
 }
 
-Buffer Buffer::operator()(int begin, int end) const
+Buffer Buffer::operator()(intptr begin, intptr end) const
 {
   return this->slice(begin, end);
 }
 
 size_t Buffer::find(const void* ptr, const size_t size) const
 {
-  size_t result = -1;
-
-  if (m_ptr == nullptr || m_size == 0 || ptr == nullptr || size == 0 || m_size < size)
-  {
-    return result;
-  }
+  return BufferView(*this).find(ptr, size);
+}
 
-  const auto ptr_bytes = this->get_ptr_bytes();
+size_t Buffer::rfind(const void* ptr, const size_t size) const
+{
+  return BufferView(*this).rfind(ptr, size);
+}
 
-  for (size_t i = 0; i <= m_size - size; i++)
-  {
-    if (memcmp(reinterpret_cast<const void*>(ptr_bytes + i), ptr, size) == 0)
-    {
-      result = i;
-      break;
-    }
-  }
+std::vector<size_t> Buffer::find_all(const void* ptr, const size_t size) const
+{
+  return BufferView(*this).find_all(ptr, size);
+}
 
-  return result;
+size_t Buffer::count(const void* ptr, const size_t size) const
+{
+  return BufferView(*this).count(ptr, size);
 }
 
 bool Buffer::match(const void* ptr, const size_t size) const
@@ -113,52 +302,27 @@ bool Buffer::match(const void* ptr, const size_t size) const
   return this->find(ptr, size) != -1;
 }
 
-Buffer Buffer::till(const void* ptr, const size_t size) const
+size_t Buffer::find(const Pattern& pattern) const
 {
-  Buffer result;
+  return BufferView(*this).find(pattern);
+}
 
-  size_t offset = this->find(ptr, size);
-  if (offset > 0)
-  {
-    result.create(m_ptr, offset);
-  }
+bool Buffer::match(const Pattern& pattern) const
+{
+  return this->find(pattern) != -1;
+}
 
+Buffer Buffer::till(const void* ptr, const size_t size) const
+{
+  Buffer result;
+  result.replace(BufferView(*this).till(ptr, size));
   return result;
 }
 
-Buffer Buffer::slice(int begin, int end) const
+Buffer Buffer::slice(intptr begin, intptr end) const
 {
   Buffer result;
-
-  if (m_ptr == nullptr || m_size == 0)
-  {
-    return result;
-  }
-
-  if (begin < 0)
-  {
-    begin = int(m_size) + begin;
-  }
-
-  if (end < 0)
-  {
-    end = int(m_size) + end;
-  }
-
-  if (begin < 0 || end < 0 || begin > int(m_size) || end > int(m_size) || begin > end)
-  {
-    return result;
-  }
-
-  int size = end - begin;
-
-  if (size <= 0 || size > int(m_size))
-  {
-    return result;
-  }
-
-  result.create(this->get_ptr_bytes() + begin, size);
-
+  result.replace(BufferView(*this).slice(begin, end));
   return result;
 }
 
@@ -177,41 +341,52 @@ size_t Buffer::get_size() const
   return m_size;
 }
 
-bool Buffer::create(void* ptr, const size_t size, const bool clean)
+size_t Buffer::get_capacity() const
 {
-  if (clean || size == 0)
-  {
-    this->destroy();
-  }
+  return m_capacity;
+}
 
+bool Buffer::create(const void* ptr, const size_t size)
+{
   if (size == 0)
   {
+    this->destroy();
     return false;
   }
 
-  if (clean)
-  {
-    m_ptr = std::calloc(m_size = size, 1);
-  }
-  else
+  // reuse the memory if it is large enough, the source could be a part of this buffer
+
+  if (size > m_capacity)
   {
-    m_ptr = std::realloc(ptr, m_size = size);
-  }
+    size_t capacity = 0;
+    void* ptr_new = this->allocate(size, capacity);
+    if (ptr_new == nullptr)
+    {
+      throw std::bad_alloc();
+    }
 
-  if (m_ptr == nullptr)
+    if (ptr != nullptr)
+    {
+      memcpy(ptr_new, ptr, size);
+    }
+
+    this->destroy();
+
+    m_ptr = ptr_new;
+    m_capacity = capacity;
+  }
+  else if (ptr != nullptr)
   {
-    throw std::bad_alloc();
+    memmove(m_ptr, ptr, size);
   }
 
   if (ptr == nullptr)
   {
-    memset(m_ptr, 0, m_size);
-  }
-  else if (clean)
-  {
-    memcpy_s(m_ptr, m_size, ptr, size);
+    memset(m_ptr, 0, size);
   }
 
+  m_size = size;
+
   return true;
 }
 
@@ -219,11 +394,12 @@ bool Buffer::destroy()
 {
   if (m_ptr != nullptr)
   {
-    std::free(m_ptr);
+    this->deallocate(m_ptr, m_capacity);
   }
 
   m_ptr = nullptr;
   m_size = 0;
+  m_capacity = 0;
 
   return true;
 }
@@ -233,6 +409,51 @@ void Buffer::reset()
   this->destroy();
 }
 
+void Buffer::swap(Buffer& right)
+{
+  if (this == &right)
+  {
+    return;
+  }
+
+  // the inline data is exchanged by copying, the heap data by the pointers
+
+  const bool l_inline = this->is_inline();
+  const bool r_inline = right.is_inline();
+
+  byte temporary[sizeof(m_inline)];
+
+  if (l_inline)
+  {
+    memcpy(temporary, m_inline, m_size);
+  }
+
+  if (r_inline)
+  {
+    memcpy(m_inline, right.m_inline, right.m_size);
+  }
+
+  if (l_inline)
+  {
+    memcpy(right.m_inline, temporary, m_size);
+  }
+
+  std::swap(m_ptr, right.m_ptr);
+  std::swap(m_size, right.m_size);
+  std::swap(m_capacity, right.m_capacity);
+  std::swap(m_pool, right.m_pool);
+
+  if (r_inline)
+  {
+    m_ptr = m_inline;
+  }
+
+  if (l_inline)
+  {
+    right.m_ptr = right.m_inline;
+  }
+}
+
 void Buffer::fill(const byte v)
 {
   if (m_ptr != nullptr && m_size != 0)
@@ -241,26 +462,115 @@ void Buffer::fill(const byte v)
   }
 }
 
-bool Buffer::resize(const size_t size)
+bool Buffer::resize(const size_t size, const bool zero)
 {
   if (size == m_size)
   {
     return true;
   }
 
-  return this->create(m_ptr, size, false);
+  this->reserve(size);
+
+  if (size > m_size && zero)
+  {
+    memset(this->get_ptr_bytes() + m_size, 0, size - m_size);
+  }
+
+  m_size = size;
+
+  return true;
 }
 
-bool Buffer::replace(const void* ptr, const size_t size)
+bool Buffer::reserve(const size_t capacity)
 {
-  if (this->create(nullptr, size))
+  if (capacity <= m_capacity)
   {
-    if (ptr != nullptr)
+    return true;
+  }
+
+  if (m_pool == nullptr && !this->is_inline() && capacity > VU_BUFFER_INLINE_SIZE)
+  {
+    void* ptr = std::realloc(m_ptr, capacity);
+    if (ptr == nullptr)
     {
-      memcpy_s(m_ptr, m_size, ptr, size);
+      throw std::bad_alloc();
     }
+
+    m_ptr = ptr;
+    m_capacity = capacity;
+
+    return true;
   }
 
+  size_t capacity_new = 0;
+  void* ptr = this->allocate(capacity, capacity_new);
+  if (ptr == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+
+  if (m_size != 0)
+  {
+    memcpy(ptr, m_ptr, m_size);
+  }
+
+  this->deallocate(m_ptr, m_capacity);
+
+  m_ptr = ptr;
+  m_capacity = capacity_new;
+
+  return true;
+}
+
+bool Buffer::shrink_to_fit()
+{
+  if (m_size == m_capacity || this->is_inline())
+  {
+    return true;
+  }
+
+  if (m_size == 0)
+  {
+    return this->destroy();
+  }
+
+  if (m_pool == nullptr && m_size > VU_BUFFER_INLINE_SIZE)
+  {
+    void* ptr = std::realloc(m_ptr, m_size);
+    if (ptr == nullptr)
+    {
+      return false; // the original memory is still valid
+    }
+
+    m_ptr = ptr;
+    m_capacity = m_size;
+
+    return true;
+  }
+
+  // the pooled capacity is the size class, so move to a smaller class or to the inline storage only
+
+  size_t capacity = 0;
+  void* ptr = this->allocate(m_size, capacity);
+  if (ptr == nullptr || capacity >= m_capacity)
+  {
+    this->deallocate(ptr, capacity);
+    return ptr != nullptr;
+  }
+
+  memcpy(ptr, m_ptr, m_size);
+
+  this->deallocate(m_ptr, m_capacity);
+
+  m_ptr = ptr;
+  m_capacity = capacity;
+
+  return true;
+}
+
+bool Buffer::replace(const void* ptr, const size_t size)
+{
+  this->create(ptr, size);
   return true;
 }
 
@@ -269,6 +579,11 @@ bool Buffer::replace(const Buffer& right)
   return this->replace(right.get_ptr(), right.get_size());
 }
 
+bool Buffer::replace(const BufferView& view)
+{
+  return this->replace(view.get_ptr(), view.get_size());
+}
+
 bool Buffer::empty() const
 {
   return m_ptr == nullptr || m_size == 0;
@@ -281,11 +596,33 @@ bool Buffer::append(const void* ptr, const size_t size)
     return false;
   }
 
-  const size_t prev_size = m_size;
+  const size_t new_size = m_size + size;
+
+  if (new_size > m_capacity)
+  {
+    // the source could be a part of this buffer that is moved by the growing
+
+    const auto ptr_bytes = static_cast<const byte*>(ptr);
+    const bool inside = ptr_bytes >= this->get_ptr_bytes() && ptr_bytes < this->get_ptr_bytes() + m_size;
+    const size_t offset = inside ? size_t(ptr_bytes - this->get_ptr_bytes()) : 0;
+
+    size_t capacity = m_capacity + m_capacity / 2;
+    if (capacity < new_size)
+    {
+      capacity = new_size;
+    }
+
+    this->reserve(capacity);
+
+    if (inside)
+    {
+      ptr = this->get_ptr_bytes() + offset;
+    }
+  }
 
-  this->resize(m_size + size);
+  memcpy(this->get_ptr_bytes() + m_size, ptr, size);
 
-  memcpy_s(this->get_ptr_bytes() + prev_size, size, ptr, size);
+  m_size = new_size;
 
   return true;
 }
@@ -295,6 +632,76 @@ bool Buffer::append(const Buffer& right)
   return this->append(right.get_ptr(), right.get_size());
 }
 
+bool Buffer::append(const BufferView& view)
+{
+  return this->append(view.get_ptr(), view.get_size());
+}
+
+BufferPool* Buffer::get_pool() const
+{
+  return m_pool;
+}
+
+bool Buffer::set_pool(BufferPool* pool)
+{
+  if (pool == m_pool)
+  {
+    return true;
+  }
+
+  // move the data to a memory of the new pool, the old memory is freed to the old pool by the temporary
+
+  Buffer temporary;
+  temporary.m_pool = pool;
+  temporary.create(m_ptr, m_size);
+
+  this->swap(temporary);
+
+  return true;
+}
+
+bool Buffer::is_inline() const
+{
+  return m_ptr == static_cast<const void*>(m_inline);
+}
+
+void* Buffer::allocate(const size_t size, size_t& capacity)
+{
+  // the small data is stored inline, the inline data only asks for a larger size
+
+  if (size <= VU_BUFFER_INLINE_SIZE && !this->is_inline())
+  {
+    capacity = VU_BUFFER_INLINE_SIZE;
+    return m_inline;
+  }
+
+  if (m_pool != nullptr)
+  {
+    return m_pool->allocate(size, capacity);
+  }
+
+  capacity = size;
+
+  return std::malloc(size);
+}
+
+void Buffer::deallocate(void* ptr, const size_t capacity)
+{
+  if (ptr == static_cast<void*>(m_inline))
+  {
+    return;
+  }
+
+  if (m_pool != nullptr)
+  {
+    m_pool->deallocate(ptr, capacity);
+  }
+  else
+  {
+    std::free(ptr);
+  }
+}
+
 std::string Buffer::to_string_A() const
 {
   return std::string(reinterpret_cast<const char*>(m_ptr), m_size / sizeof(char));
@@ -327,4 +734,136 @@ bool Buffer::save_to_file(const std::wstring& file_path)
   return this->save_to_file(s);
 }
 
+
+/**
+ * BufferChain
+ */
+
+BufferView BufferChain::Segment::data() const
+{
+  const BufferView whole = owned ? BufferView(buffer) : view;
+  return BufferView(whole.get_ptr_bytes() + offset, whole.get_size() - offset);
+}
+
+BufferChain::BufferChain() : m_size(0)
+{
+}
+
+BufferChain::~BufferChain()
+{
+}
+
+void BufferChain::append(const BufferView& view)
+{
+  if (view.empty())
+  {
+    return;
+  }
+
+  m_segments.push_back(Segment());
+
+  auto& segment = m_segments.back();
+  segment.owned = false;
+  segment.view = view;
+  segment.offset = 0;
+
+  m_size += view.get_size();
+}
+
+void BufferChain::append(const Buffer& buffer)
+{
+  this->append(Buffer(buffer));
+}
+
+void BufferChain::append(Buffer&& buffer)
+{
+  if (buffer.empty())
+  {
+    return;
+  }
+
+  // the segment is constructed in place then the data is swapped in, so it is never copied
+
+  m_segments.push_back(Segment());
+
+  auto& segment = m_segments.back();
+  segment.owned = true;
+  segment.buffer.swap(buffer);
+  segment.offset = 0;
+
+  m_size += segment.buffer.get_size();
+}
+
+void BufferChain::clear()
+{
+  m_segments.clear();
+  m_size = 0;
+}
+
+size_t BufferChain::consume(const size_t size)
+{
+  size_t consumed = 0;
+
+  while (consumed < size && !m_segments.empty())
+  {
+    auto& segment = m_segments.front();
+
+    const size_t remaining = segment.data().get_size();
+    const size_t n = size - consumed < remaining ? size - consumed : remaining;
+
+    if (n == remaining)
+    {
+      m_segments.pop_front();
+    }
+    else
+    {
+      segment.offset += n;
+    }
+
+    consumed += n;
+  }
+
+  m_size -= consumed;
+
+  return consumed;
+}
+
+bool BufferChain::empty() const
+{
+  return m_size == 0;
+}
+
+size_t BufferChain::get_size() const
+{
+  return m_size;
+}
+
+size_t BufferChain::count() const
+{
+  return m_segments.size();
+}
+
+BufferView BufferChain::at(const size_t index) const
+{
+  if (index >= m_segments.size())
+  {
+    throw std::out_of_range(static_cast<const char*>("invalid index"));
+  }
+
+  return m_segments[index].data();
+}
+
+Buffer BufferChain::flatten() const
+{
+  Buffer result;
+  result.reserve(m_size);
+
+  for (const auto& segment : m_segments)
+  {
+    result.append(segment.data());
+  }
+
+  return result;
+}
+
 } // namespace vu
\ No newline at end of file
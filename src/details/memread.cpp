@@ -0,0 +1,259 @@
+/**
+ * @file   memread.cpp
+ * @author Vic P.
+ * @brief  Implementation for Batch Reader
+ */
+
+#include "Vutils.h"
+
+#include <algorithm>
+
+namespace vu
+{
+
+static const size_t BATCH_READ_MAX_SPAN = 0x10000; // The maximum size of a merged read
+
+BatchReader::BatchReader(const arch bit, const HANDLE hp, const ulong staleness, const size_t max_gap)
+  : LastError(), m_bit(bit), m_hp(hp), m_staleness(staleness), m_max_gap(max_gap)
+{
+}
+
+BatchReader::~BatchReader()
+{
+}
+
+void BatchReader::invalidate()
+{
+  m_pointers.clear();
+}
+
+size_t BatchReader::read(TRequests& requests, const bool force)
+{
+  std::vector<size_t> indices(requests.size());
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    indices[i] = i;
+    requests[i].result = false;
+  }
+
+  std::sort(indices.begin(), indices.end(), [&](const size_t l, const size_t r) -> bool
+  {
+    return requests[l].address < requests[r].address;
+  });
+
+  size_t count = 0;
+
+  for (size_t i = 0; i < indices.size();)
+  {
+    // merge the next requests while they are near enough and the span is not too large
+
+    const ulongptr begin = requests[indices[i]].address;
+    ulongptr end = begin + requests[indices[i]].size;
+
+    size_t n = 1;
+    for (; i + n < indices.size(); n++)
+    {
+      const auto& request = requests[indices[i + n]];
+      if (request.address > end + m_max_gap || request.address + request.size - begin > BATCH_READ_MAX_SPAN)
+      {
+        break;
+      }
+
+      if (request.address + request.size > end)
+      {
+        end = request.address + request.size;
+      }
+    }
+
+    bool merged = false;
+
+    if (n > 1)
+    {
+      m_buffer.resize(size_t(end - begin));
+      merged = read_memory(m_hp, LPCVOID(begin), m_buffer.data(), m_buffer.size(), force);
+    }
+
+    // the requests are read one by one if the merged read failed (eg. the span crosses a hole)
+
+    for (size_t j = i; j < i + n; j++)
+    {
+      auto& request = requests[indices[j]];
+
+      if (merged)
+      {
+        memcpy(request.buffer, m_buffer.data() + (request.address - begin), request.size);
+        request.result = true;
+      }
+      else
+      {
+        request.result = read_memory(m_hp, LPCVOID(request.address), request.buffer, request.size, force);
+      }
+
+      if (request.result)
+      {
+        count++;
+      }
+    }
+
+    i += n;
+  }
+
+  m_last_error_code = count == requests.size() ? ERROR_SUCCESS : ERROR_PARTIAL_COPY;
+
+  return count;
+}
+
+size_t BatchReader::resolve(std::vector<ulongptr>& addresses, const TChains& chains)
+{
+  const ulong tick = GetTickCount();
+
+  // drop the stale pointers
+
+  for (auto it = m_pointers.begin(); it != m_pointers.end();)
+  {
+    it = tick - it->second.tick > m_staleness ? m_pointers.erase(it) : std::next(it);
+  }
+
+  addresses.resize(chains.size());
+
+  std::vector<bool> alive(chains.size(), true);
+
+  size_t n_levels = 0;
+  for (size_t i = 0; i < chains.size(); i++)
+  {
+    addresses[i] = chains[i].address;
+    if (chains[i].offsets.size() > n_levels)
+    {
+      n_levels = chains[i].offsets.size();
+    }
+  }
+
+  std::vector<ulongptr> misses;
+  std::vector<ulongptr> values;
+  TRequests requests;
+
+  for (size_t level = 0; level < n_levels; level++)
+  {
+    // collect the pointer locations of this level those are not cached
+
+    misses.clear();
+
+    for (size_t i = 0; i < chains.size(); i++)
+    {
+      if (alive[i] && level < chains[i].offsets.size() && m_pointers.count(addresses[i]) == 0)
+      {
+        misses.push_back(addresses[i]);
+      }
+    }
+
+    std::sort(misses.begin(), misses.end());
+    misses.erase(std::unique(misses.begin(), misses.end()), misses.end());
+
+    // read them in a batch, the pointers of the 32-bit processes fill the low bytes only
+
+    values.assign(misses.size(), 0);
+    requests.resize(misses.size());
+
+    for (size_t i = 0; i < misses.size(); i++)
+    {
+      requests[i].address = misses[i];
+      requests[i].buffer = &values[i];
+      requests[i].size = m_bit;
+      requests[i].result = false;
+    }
+
+    this->read(requests);
+
+    // follow the pointers to the next level
+
+    for (size_t i = 0; i < chains.size(); i++)
+    {
+      if (!alive[i] || level >= chains[i].offsets.size())
+      {
+        continue;
+      }
+
+      ulongptr pointer = 0;
+
+      const auto it = m_pointers.find(addresses[i]);
+      if (it != m_pointers.cend())
+      {
+        pointer = it->second.value;
+      }
+      else
+      {
+        const size_t j = std::lower_bound(misses.cbegin(), misses.cend(), addresses[i]) - misses.cbegin();
+        if (!requests[j].result)
+        {
+          alive[i] = false;
+          addresses[i] = 0;
+          continue;
+        }
+
+        pointer = values[j];
+      }
+
+      addresses[i] = pointer + chains[i].offsets[level];
+    }
+
+    if (m_staleness != 0)
+    {
+      for (size_t i = 0; i < misses.size(); i++)
+      {
+        if (requests[i].result)
+        {
+          Pointer pointer = { values[i], tick };
+          m_pointers[misses[i]] = pointer;
+        }
+      }
+    }
+  }
+
+  const size_t count = std::count(alive.cbegin(), alive.cend(), true);
+
+  m_last_error_code = count == chains.size() ? ERROR_SUCCESS : ERROR_PARTIAL_COPY;
+
+  return count;
+}
+
+size_t BatchReader::read(TRequests& requests, const TChains& chains, const bool force)
+{
+  if (requests.size() != chains.size())
+  {
+    m_last_error_code = ERROR_INVALID_PARAMETER;
+    return 0;
+  }
+
+  std::vector<ulongptr> addresses;
+  this->resolve(addresses, chains);
+
+  // read the resolved ones only, the unresolved ones are failed
+
+  TRequests resolved;
+  std::vector<size_t> indices;
+
+  for (size_t i = 0; i < requests.size(); i++)
+  {
+    requests[i].address = addresses[i];
+    requests[i].result = false;
+
+    if (addresses[i] != 0)
+    {
+      resolved.push_back(requests[i]);
+      indices.push_back(i);
+    }
+  }
+
+  const size_t count = this->read(resolved, force);
+
+  for (size_t i = 0; i < resolved.size(); i++)
+  {
+    requests[indices[i]].result = resolved[i].result;
+  }
+
+  m_last_error_code = count == requests.size() ? ERROR_SUCCESS : ERROR_PARTIAL_COPY;
+
+  return count;
+}
+
+} // namespace vu
@@ -0,0 +1,1252 @@
+/**
+ * @file   memscan.cpp
+ * @author Vic P.
+ * @brief  Implementation for Memory Scanning
+ */
+
+#include "Vutils.h"
+#include "memscan.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vu
+{
+
+static const size_t SCAN_PAGE_SIZE = 0x1000;
+static const size_t SCAN_READ_SIZE = 0x100000; // The maximum size of a read, 256 pages
+
+/**
+ * Memory Ranges
+ */
+
+std::vector<MemoryRange> coalesce_memories(const ProcessX::memories& memories)
+{
+  std::vector<MemoryRange> result;
+
+  bool mergeable = false;
+
+  for (const auto& mem : memories)
+  {
+    MemoryRange range;
+    range.begin = ulongptr(mem.BaseAddress);
+    range.end = range.begin + mem.RegionSize;
+
+    const bool readable = (mem.State & MEM_COMMIT) != 0 && (mem.Protect & (PAGE_GUARD | PAGE_NOACCESS)) == 0;
+
+    if (readable && mergeable && result.back().end == range.begin)
+    {
+      result.back().end = range.end;
+    }
+    else
+    {
+      result.push_back(range);
+    }
+
+    mergeable = readable;
+  }
+
+  return result;
+}
+
+/**
+ * The 64-bit hash of a page content and its tail, the rotation lets the changes of the high bits reach
+ * the low bits so the different changes of the words are unlikely to cancel each other out.
+ */
+
+static uint64 hash_page(const byte* ptr, const size_t tail)
+{
+  uint64 result = 0x9E3779B97F4A7C15ULL;
+
+  const auto mix = [&](const uint64 word) -> void
+  {
+    result ^= word * 0x87C37B91114253D5ULL;
+    result  = ((result << 27) | (result >> 37)) * 5 + 0x52DCE729;
+  };
+
+  for (size_t i = 0; i < SCAN_PAGE_SIZE; i += sizeof(uint64))
+  {
+    uint64 word = 0;
+    memcpy(&word, ptr + i, sizeof(word));
+    mix(word);
+  }
+
+  if (tail != 0)
+  {
+    uint64 word = 0;
+    memcpy(&word, ptr + SCAN_PAGE_SIZE, tail);
+    mix(word);
+  }
+
+  result ^= result >> 33;
+  result *= 0xFF51AFD7ED558CCDULL;
+  result ^= result >> 33;
+
+  return result;
+}
+
+/**
+ * Typed Comparison
+ */
+
+template <typename T>
+static inline T load_value(const byte* ptr)
+{
+  T result;
+  memcpy(&result, ptr, sizeof(T));
+  return result;
+}
+
+template <typename T>
+static inline T to_value(const ScanValue& value)
+{
+  return value.floating ? T(value.real) : T(value.integer);
+}
+
+template <typename T>
+static inline T next_value(const T value, const T toward, std::true_type /* floating-point */)
+{
+  return std::nextafter(value, toward);
+}
+
+template <typename T>
+static inline T next_value(const T value, const T toward, std::false_type /* integer */)
+{
+  return value < toward ? T(value + 1) : T(value - 1);
+}
+
+/**
+ * Convert an absolute comparison to an inclusive range [lo, hi] of the matched values.
+ * @return False if no value could match.
+ */
+
+template <typename T>
+static bool make_range(
+  const scan_compare_type compare,
+  const ScanValue& value,
+  const ScanValue& upper,
+  const double tolerance,
+  T& lo,
+  T& hi)
+{
+  typedef std::numeric_limits<T> limits;
+  typedef std::is_floating_point<T> floating;
+
+  const T min_value = limits::has_infinity ? -limits::infinity() : limits::lowest();
+  const T max_value = limits::has_infinity ?  limits::infinity() : (limits::max)();
+  const T eps = floating::value ? T(tolerance) : T(0);
+  const T v = to_value<T>(value);
+
+  switch (compare)
+  {
+  case scan_compare_type::SCT_EQUALS:
+    lo = T(v - eps);
+    hi = T(v + eps);
+    break;
+
+  case scan_compare_type::SCT_GREATER:
+    if (!(v < max_value))
+    {
+      return false;
+    }
+    lo = next_value(v, max_value, floating());
+    hi = max_value;
+    break;
+
+  case scan_compare_type::SCT_LESS:
+    if (!(v > min_value))
+    {
+      return false;
+    }
+    lo = min_value;
+    hi = next_value(v, min_value, floating());
+    break;
+
+  case scan_compare_type::SCT_BETWEEN:
+    {
+      const T u = to_value<T>(upper);
+      lo = T((u < v ? u : v) - eps);
+      hi = T((u < v ? v : u) + eps);
+    }
+    break;
+
+  default:
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Compare the current value of a candidate to its previous value.
+ * The bitwise identical values are always unchanged (eg. NaN), the integers ignore the tolerance.
+ */
+
+template <typename T>
+static inline bool compare_relative(
+  const scan_compare_type compare, const byte* current, const byte* previous, const T eps)
+{
+  bool same = memcmp(current, previous, sizeof(T)) == 0;
+
+  const T c = load_value<T>(current);
+  const T p = load_value<T>(previous);
+
+  if (!same && eps > T(0))
+  {
+    same = (c > p ? c - p : p - c) <= eps;
+  }
+
+  switch (compare)
+  {
+  case scan_compare_type::SCT_CHANGED:
+    return !same;
+  case scan_compare_type::SCT_UNCHANGED:
+    return same;
+  case scan_compare_type::SCT_INCREASED:
+    return !same && c > p;
+  case scan_compare_type::SCT_DECREASED:
+    return !same && c < p;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Range Kernels
+ * Build the bitmap of the aligned values of a whole page those are in an inclusive range.
+ * The unsigned integers are biased by flipping their sign bit so the signed comparisons work.
+ * The 64-bit integers are scalar without AVX2 because SSE2 has no 64-bit comparison.
+ */
+
+#ifdef VU_SIMD_X86
+
+VU_TARGET_AVX2 static void range_mask_avx2(
+  const byte* ptr, const int8 lo, const int8 hi, const int8 bias, uint64* mask)
+{
+  const __m256i vb = _mm256_set1_epi8(bias);
+  const __m256i vl = _mm256_set1_epi8(lo);
+  const __m256i vh = _mm256_set1_epi8(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 64; w++, ptr += 64)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 2; k++)
+    {
+      const __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(ptr + k * 32)), vb);
+      const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi8(vl, x), _mm256_cmpgt_epi8(x, vh));
+      bits |= uint64(~uint32(_mm256_movemask_epi8(out))) << (k * 32);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_AVX2 static void range_mask_avx2(
+  const byte* ptr, const int16 lo, const int16 hi, const int16 bias, uint64* mask)
+{
+  const __m256i vb = _mm256_set1_epi16(bias);
+  const __m256i vl = _mm256_set1_epi16(lo);
+  const __m256i vh = _mm256_set1_epi16(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 128; w++, ptr += 128)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 2; k++)
+    {
+      const __m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(ptr + k * 64)), vb);
+      const __m256i b = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(ptr + k * 64 + 32)), vb);
+      const __m256i out_a = _mm256_or_si256(_mm256_cmpgt_epi16(vl, a), _mm256_cmpgt_epi16(a, vh));
+      const __m256i out_b = _mm256_or_si256(_mm256_cmpgt_epi16(vl, b), _mm256_cmpgt_epi16(b, vh));
+      // the packing works per 128-bit lane so the 64-bit quarters are reordered back
+      const __m256i out = _mm256_permute4x64_epi64(_mm256_packs_epi16(out_a, out_b), 0xD8);
+      bits |= uint64(~uint32(_mm256_movemask_epi8(out))) << (k * 32);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_AVX2 static void range_mask_avx2(
+  const byte* ptr, const int32 lo, const int32 hi, const int32 bias, uint64* mask)
+{
+  const __m256i vb = _mm256_set1_epi32(bias);
+  const __m256i vl = _mm256_set1_epi32(lo);
+  const __m256i vh = _mm256_set1_epi32(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 256; w++, ptr += 256)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 8; k++)
+    {
+      const __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(ptr + k * 32)), vb);
+      const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vl, x), _mm256_cmpgt_epi32(x, vh));
+      bits |= uint64(~_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xFF) << (k * 8);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_AVX2 static void range_mask_avx2(
+  const byte* ptr, const int64 lo, const int64 hi, const int64 bias, uint64* mask)
+{
+  const __m256i vb = _mm256_set1_epi64x(bias);
+  const __m256i vl = _mm256_set1_epi64x(lo);
+  const __m256i vh = _mm256_set1_epi64x(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 512; w++, ptr += 512)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 16; k++)
+    {
+      const __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(ptr + k * 32)), vb);
+      const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(vl, x), _mm256_cmpgt_epi64(x, vh));
+      bits |= uint64(~_mm256_movemask_pd(_mm256_castsi256_pd(out)) & 0xF) << (k * 4);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_AVX2 static void range_mask_avx2(const byte* ptr, const float lo, const float hi, uint64* mask)
+{
+  const __m256 vl = _mm256_set1_ps(lo);
+  const __m256 vh = _mm256_set1_ps(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 256; w++, ptr += 256)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 8; k++)
+    {
+      const __m256 x = _mm256_loadu_ps((const float*)(ptr + k * 32));
+      const __m256 in = _mm256_and_ps(_mm256_cmp_ps(x, vl, _CMP_GE_OQ), _mm256_cmp_ps(x, vh, _CMP_LE_OQ));
+      bits |= uint64(_mm256_movemask_ps(in)) << (k * 8);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_AVX2 static void range_mask_avx2(const byte* ptr, const double lo, const double hi, uint64* mask)
+{
+  const __m256d vl = _mm256_set1_pd(lo);
+  const __m256d vh = _mm256_set1_pd(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 512; w++, ptr += 512)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 16; k++)
+    {
+      const __m256d x = _mm256_loadu_pd((const double*)(ptr + k * 32));
+      const __m256d in = _mm256_and_pd(_mm256_cmp_pd(x, vl, _CMP_GE_OQ), _mm256_cmp_pd(x, vh, _CMP_LE_OQ));
+      bits |= uint64(_mm256_movemask_pd(in)) << (k * 4);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_SSE2 static void range_mask_sse2(
+  const byte* ptr, const int8 lo, const int8 hi, const int8 bias, uint64* mask)
+{
+  const __m128i vb = _mm_set1_epi8(bias);
+  const __m128i vl = _mm_set1_epi8(lo);
+  const __m128i vh = _mm_set1_epi8(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 64; w++, ptr += 64)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 4; k++)
+    {
+      const __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(ptr + k * 16)), vb);
+      const __m128i out = _mm_or_si128(_mm_cmplt_epi8(x, vl), _mm_cmpgt_epi8(x, vh));
+      bits |= uint64(~_mm_movemask_epi8(out) & 0xFFFF) << (k * 16);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_SSE2 static void range_mask_sse2(
+  const byte* ptr, const int16 lo, const int16 hi, const int16 bias, uint64* mask)
+{
+  const __m128i vb = _mm_set1_epi16(bias);
+  const __m128i vl = _mm_set1_epi16(lo);
+  const __m128i vh = _mm_set1_epi16(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 128; w++, ptr += 128)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 4; k++)
+    {
+      const __m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(ptr + k * 32)), vb);
+      const __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(ptr + k * 32 + 16)), vb);
+      const __m128i out_a = _mm_or_si128(_mm_cmplt_epi16(a, vl), _mm_cmpgt_epi16(a, vh));
+      const __m128i out_b = _mm_or_si128(_mm_cmplt_epi16(b, vl), _mm_cmpgt_epi16(b, vh));
+      const __m128i out = _mm_packs_epi16(out_a, out_b);
+      bits |= uint64(~_mm_movemask_epi8(out) & 0xFFFF) << (k * 16);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_SSE2 static void range_mask_sse2(
+  const byte* ptr, const int32 lo, const int32 hi, const int32 bias, uint64* mask)
+{
+  const __m128i vb = _mm_set1_epi32(bias);
+  const __m128i vl = _mm_set1_epi32(lo);
+  const __m128i vh = _mm_set1_epi32(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 256; w++, ptr += 256)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 16; k++)
+    {
+      const __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(ptr + k * 16)), vb);
+      const __m128i out = _mm_or_si128(_mm_cmplt_epi32(x, vl), _mm_cmpgt_epi32(x, vh));
+      bits |= uint64(~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xF) << (k * 4);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_SSE2 static void range_mask_sse2(const byte* ptr, const float lo, const float hi, uint64* mask)
+{
+  const __m128 vl = _mm_set1_ps(lo);
+  const __m128 vh = _mm_set1_ps(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 256; w++, ptr += 256)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 16; k++)
+    {
+      const __m128 x = _mm_loadu_ps((const float*)(ptr + k * 16));
+      const __m128 in = _mm_and_ps(_mm_cmpge_ps(x, vl), _mm_cmple_ps(x, vh));
+      bits |= uint64(_mm_movemask_ps(in)) << (k * 4);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+VU_TARGET_SSE2 static void range_mask_sse2(const byte* ptr, const double lo, const double hi, uint64* mask)
+{
+  const __m128d vl = _mm_set1_pd(lo);
+  const __m128d vh = _mm_set1_pd(hi);
+
+  for (size_t w = 0; w < SCAN_PAGE_SIZE / 512; w++, ptr += 512)
+  {
+    uint64 bits = 0;
+
+    for (size_t k = 0; k < 32; k++)
+    {
+      const __m128d x = _mm_loadu_pd((const double*)(ptr + k * 16));
+      const __m128d in = _mm_and_pd(_mm_cmpge_pd(x, vl), _mm_cmple_pd(x, vh));
+      bits |= uint64(_mm_movemask_pd(in)) << (k * 2);
+    }
+
+    mask[w] = bits;
+  }
+}
+
+/**
+ * SSE2 has no 64-bit comparison, so the 64-bit integers are routed to scalar at compile time.
+ */
+
+template <typename S>
+static bool range_mask_int_sse2(const byte* ptr, const S lo, const S hi, const S bias, uint64* mask, std::true_type)
+{
+  range_mask_sse2(ptr, lo, hi, bias, mask);
+  return true;
+}
+
+template <typename S>
+static bool range_mask_int_sse2(const byte*, const S, const S, const S, uint64*, std::false_type)
+{
+  return false;
+}
+
+#endif // VU_SIMD_X86
+
+/**
+ * The SIMD dispatchers of the range kernels.
+ * @return False if there is no available kernel for the type, then the caller falls back to scalar.
+ */
+
+template <typename S, typename T>
+static bool range_mask_int(const byte* ptr, const T lo, const T hi, uint64* mask)
+{
+  #ifdef VU_SIMD_X86
+  const S bias = std::is_signed<T>::value ? S(0) : (std::numeric_limits<S>::min)();
+  const S l = S(S(lo) ^ bias);
+  const S h = S(S(hi) ^ bias);
+
+  const auto& cpu = CPUFeatures::instance();
+
+  if (cpu.avx2)
+  {
+    range_mask_avx2(ptr, l, h, bias, mask);
+    return true;
+  }
+
+  if (cpu.sse2)
+  {
+    return range_mask_int_sse2(ptr, l, h, bias, mask, std::integral_constant<bool, (sizeof(S) < sizeof(int64))>());
+  }
+  #endif // VU_SIMD_X86
+
+  return false;
+}
+
+template <typename T>
+static bool range_mask_real(const byte* ptr, const T lo, const T hi, uint64* mask)
+{
+  #ifdef VU_SIMD_X86
+  const auto& cpu = CPUFeatures::instance();
+
+  if (cpu.avx2)
+  {
+    range_mask_avx2(ptr, lo, hi, mask);
+    return true;
+  }
+
+  if (cpu.sse2)
+  {
+    range_mask_sse2(ptr, lo, hi, mask);
+    return true;
+  }
+  #endif // VU_SIMD_X86
+
+  return false;
+}
+
+static bool range_mask_simd(const byte* p, const int8 lo, const int8 hi, uint64* m)
+{
+  return range_mask_int<int8>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const uint8 lo, const uint8 hi, uint64* m)
+{
+  return range_mask_int<int8>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const int16 lo, const int16 hi, uint64* m)
+{
+  return range_mask_int<int16>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const uint16 lo, const uint16 hi, uint64* m)
+{
+  return range_mask_int<int16>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const int32 lo, const int32 hi, uint64* m)
+{
+  return range_mask_int<int32>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const uint32 lo, const uint32 hi, uint64* m)
+{
+  return range_mask_int<int32>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const int64 lo, const int64 hi, uint64* m)
+{
+  return range_mask_int<int64>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const uint64 lo, const uint64 hi, uint64* m)
+{
+  return range_mask_int<int64>(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const float lo, const float hi, uint64* m)
+{
+  return range_mask_real(p, lo, hi, m);
+}
+
+static bool range_mask_simd(const byte* p, const double lo, const double hi, uint64* m)
+{
+  return range_mask_real(p, lo, hi, m);
+}
+
+/**
+ * Build the bitmap of the values of a whole page those are in an inclusive range.
+ */
+
+template <typename T>
+static void range_mask_T(
+  const byte* ptr, const size_t n_slots, const size_t step, const T lo, const T hi, uint64* mask)
+{
+  if (step == sizeof(T) && range_mask_simd(ptr, lo, hi, mask))
+  {
+    return;
+  }
+
+  memset(mask, 0, (n_slots + 63) / 64 * sizeof(uint64));
+
+  for (size_t slot = 0; slot < n_slots; slot++)
+  {
+    const T v = load_value<T>(ptr + slot * step);
+    if (lo <= v && v <= hi)
+    {
+      mask[slot / 64] |= 1ULL << (slot % 64);
+    }
+  }
+}
+
+/**
+ * Build the bitmap of the unaligned values of a whole page those equal to a value.
+ * Each value byte is matched at once over the page then the byte bitmaps are shifted and combined,
+ * the values those cross the page boundary are shifted out and checked by the caller.
+ */
+
+static void equal_mask_bytes(const byte* ptr, const byte* value, const size_t size, uint64* mask)
+{
+  const size_t n_words = SCAN_PAGE_SIZE / 64;
+
+  uint64 matches[SCAN_PAGE_SIZE / 64];
+
+  for (size_t w = 0; w < n_words; w++)
+  {
+    mask[w] = ~0ULL;
+  }
+
+  for (size_t k = 0; k < size; k++)
+  {
+    range_mask_T<uint8>(ptr, SCAN_PAGE_SIZE, 1, value[k], value[k], matches);
+
+    for (size_t w = 0; w < n_words; w++)
+    {
+      uint64 bits = matches[w];
+      if (k != 0)
+      {
+        bits >>= k;
+        bits |= w + 1 < n_words ? matches[w + 1] << (64 - k) : 0;
+      }
+
+      mask[w] &= bits;
+    }
+  }
+}
+
+/**
+ * ScanSession
+ */
+
+ScanSession::ScanSession(
+  ProcessX& process, const scan_value_type type, const bool aligned, const double tolerance)
+  : LastError()
+  , m_process(process)
+  , m_type(type)
+  , m_aligned(aligned)
+  , m_tolerance(tolerance < 0. ? -tolerance : tolerance)
+  , m_scanned(false)
+  , m_count(0)
+{
+}
+
+ScanSession::~ScanSession()
+{
+}
+
+void ScanSession::reset()
+{
+  m_pages.clear();
+  m_count = 0;
+  m_scanned = false;
+}
+
+size_t ScanSession::count() const
+{
+  return m_count;
+}
+
+size_t ScanSession::value_size() const
+{
+  switch (m_type)
+  {
+  case scan_value_type::SVT_INT8:
+  case scan_value_type::SVT_UINT8:
+    return 1;
+  case scan_value_type::SVT_INT16:
+  case scan_value_type::SVT_UINT16:
+    return 2;
+  case scan_value_type::SVT_INT32:
+  case scan_value_type::SVT_UINT32:
+  case scan_value_type::SVT_FLOAT:
+    return 4;
+  default:
+    return 8;
+  }
+}
+
+size_t ScanSession::slot_step() const
+{
+  return m_aligned ? this->value_size() : 1;
+}
+
+size_t ScanSession::slot_count() const
+{
+  return SCAN_PAGE_SIZE / this->slot_step();
+}
+
+/**
+ * The bytes of the next page those the unaligned values at the end of a page cross into. They are read
+ * after the page, the last `tail_size()` slots of the page are dropped if they could not be read.
+ */
+
+size_t ScanSession::tail_size() const
+{
+  return m_aligned ? 0 : this->value_size() - 1;
+}
+
+std::vector<ulongptr> ScanSession::addresses(const size_t max_count) const
+{
+  std::vector<ulongptr> result;
+  std::vector<ushort> slots;
+
+  const size_t step = this->slot_step();
+
+  for (const auto& page : m_pages)
+  {
+    this->get_slots(page, slots);
+
+    for (const auto slot : slots)
+    {
+      if (result.size() >= max_count)
+      {
+        return result;
+      }
+
+      result.push_back(page.address + slot * step);
+    }
+  }
+
+  return result;
+}
+
+/**
+ * The candidate slots of a page are kept in the smaller form of a bitmap or the varint-encoded
+ * gaps between the consecutive slots, the gaps of a page take 1 or 2 bytes each.
+ */
+
+void ScanSession::get_slots(const Page& page, std::vector<ushort>& slots) const
+{
+  slots.clear();
+  slots.reserve(page.count);
+
+  if (!page.bitmap.empty())
+  {
+    for (size_t i = 0; i < page.bitmap.size(); i++)
+    {
+      for (uint64 bits = page.bitmap[i]; bits != 0; bits &= bits - 1)
+      {
+        slots.push_back(ushort(i * 64 + bit_scan_forward(bits)));
+      }
+    }
+
+    return;
+  }
+
+  size_t slot = 0;
+
+  for (size_t i = 0; i < page.deltas.size();)
+  {
+    size_t delta = 0;
+    size_t shift = 0;
+    byte b = 0;
+
+    do
+    {
+      b = page.deltas[i++];
+      delta |= size_t(b & 0x7F) << shift;
+      shift += 7;
+    } while ((b & 0x80) != 0 && i < page.deltas.size());
+
+    slot += delta;
+    slots.push_back(ushort(slot));
+    slot += 1;
+  }
+}
+
+void ScanSession::set_slots(Page& page, const std::vector<ushort>& slots)
+{
+  const size_t n_words = (this->slot_count() + 63) / 64;
+
+  page.count = slots.size();
+
+  if (page.count * 2 < n_words * sizeof(uint64))
+  {
+    std::vector<byte> deltas;
+    deltas.reserve(page.count * 2);
+
+    size_t next = 0;
+
+    for (const auto slot : slots)
+    {
+      size_t delta = slot - next;
+      for (; delta >= 0x80; delta >>= 7)
+      {
+        deltas.push_back(byte(delta | 0x80));
+      }
+
+      deltas.push_back(byte(delta));
+      next = slot + 1;
+    }
+
+    page.deltas.swap(deltas);
+    std::vector<uint64>().swap(page.bitmap);
+  }
+  else
+  {
+    std::vector<uint64> bitmap(n_words, 0);
+
+    for (const auto slot : slots)
+    {
+      bitmap[slot / 64] |= 1ULL << (slot % 64);
+    }
+
+    page.bitmap.swap(bitmap);
+    std::vector<byte>().swap(page.deltas);
+  }
+}
+
+void ScanSession::set_slots(Page& page, const uint64* bitmap)
+{
+  const size_t n_words = (this->slot_count() + 63) / 64;
+
+  size_t count = 0;
+  for (size_t i = 0; i < n_words; i++)
+  {
+    count += pop_count(bitmap[i]);
+  }
+
+  if (count * 2 < n_words * sizeof(uint64))
+  {
+    m_slots.clear();
+
+    for (size_t i = 0; i < n_words; i++)
+    {
+      for (uint64 bits = bitmap[i]; bits != 0; bits &= bits - 1)
+      {
+        m_slots.push_back(ushort(i * 64 + bit_scan_forward(bits)));
+      }
+    }
+
+    this->set_slots(page, m_slots);
+  }
+  else
+  {
+    page.count = count;
+    page.bitmap.assign(bitmap, bitmap + n_words);
+    std::vector<byte>().swap(page.deltas);
+  }
+}
+
+/**
+ * Filter the candidate slots of a page by their current values.
+ * The absolute comparisons of the dense pages are done for the whole page by the range kernels,
+ * the sparse pages and the relative comparisons check their candidates one by one.
+ */
+
+template <typename T>
+void ScanSession::scan_page_T(
+  Page& page,
+  const byte* ptr,
+  const scan_compare_type compare,
+  const ScanValue& value,
+  const ScanValue& upper)
+{
+  const size_t n_slots = this->slot_count();
+  const size_t step = this->slot_step();
+
+  // the slots those cross into the next page are valid only if its bytes are read after the page
+
+  const size_t n_valid = page.tail ? n_slots : n_slots - this->tail_size();
+
+  switch (compare)
+  {
+  case scan_compare_type::SCT_EQUALS:
+  case scan_compare_type::SCT_GREATER:
+  case scan_compare_type::SCT_LESS:
+  case scan_compare_type::SCT_BETWEEN:
+    {
+      T lo = T(0), hi = T(0);
+      if (!make_range(compare, value, upper, m_tolerance, lo, hi))
+      {
+        m_slots.clear();
+        this->set_slots(page, m_slots);
+        return;
+      }
+
+      if (!page.bitmap.empty())
+      {
+        uint64 mask[SCAN_PAGE_SIZE / 64];
+
+        if (compare == scan_compare_type::SCT_EQUALS &&
+          step == 1 && sizeof(T) > 1 && !std::is_floating_point<T>::value)
+        {
+          const T v = to_value<T>(value);
+          equal_mask_bytes(ptr, reinterpret_cast<const byte*>(&v), sizeof(T), mask);
+
+          for (size_t slot = SCAN_PAGE_SIZE - sizeof(T) + 1; slot < n_valid; slot++)
+          {
+            if (load_value<T>(ptr + slot) == v)
+            {
+              mask[slot / 64] |= 1ULL << (slot % 64);
+            }
+          }
+        }
+        else
+        {
+          range_mask_T<T>(ptr, n_slots, step, lo, hi, mask);
+        }
+
+        for (size_t slot = n_valid; slot < n_slots; slot++)
+        {
+          mask[slot / 64] &= ~(1ULL << (slot % 64));
+        }
+
+        for (size_t i = 0; i < page.bitmap.size(); i++)
+        {
+          mask[i] &= page.bitmap[i];
+        }
+
+        this->set_slots(page, mask);
+        return;
+      }
+
+      this->get_slots(page, m_slots);
+
+      size_t n = 0;
+      for (const auto slot : m_slots)
+      {
+        if (slot >= n_valid)
+        {
+          break;
+        }
+
+        const T v = load_value<T>(ptr + slot * step);
+        if (lo <= v && v <= hi)
+        {
+          m_slots[n++] = slot;
+        }
+      }
+
+      m_slots.resize(n);
+      this->set_slots(page, m_slots);
+    }
+    break;
+
+  default:
+    {
+      const T eps = std::is_floating_point<T>::value ? T(m_tolerance) : T(0);
+      const byte* previous = page.values.data();
+
+      this->get_slots(page, m_slots);
+
+      size_t n = 0;
+      for (size_t rank = 0; rank < m_slots.size(); rank++)
+      {
+        const size_t slot = m_slots[rank];
+        if (slot >= n_valid)
+        {
+          break;
+        }
+
+        const byte* p = previous + (page.whole ? slot * step : rank * sizeof(T));
+        if (compare_relative<T>(compare, ptr + slot * step, p, eps))
+        {
+          m_slots[n++] = ushort(slot);
+        }
+      }
+
+      m_slots.resize(n);
+      this->set_slots(page, m_slots);
+    }
+    break;
+  }
+}
+
+void ScanSession::scan_page(
+  Page& page,
+  const byte* ptr,
+  const scan_compare_type compare,
+  const ScanValue& value,
+  const ScanValue& upper)
+{
+  switch (m_type)
+  {
+  case scan_value_type::SVT_INT8:
+    this->scan_page_T<int8>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_UINT8:
+    this->scan_page_T<uint8>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_INT16:
+    this->scan_page_T<int16>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_UINT16:
+    this->scan_page_T<uint16>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_INT32:
+    this->scan_page_T<int32>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_UINT32:
+    this->scan_page_T<uint32>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_INT64:
+    this->scan_page_T<int64>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_UINT64:
+    this->scan_page_T<uint64>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_FLOAT:
+    this->scan_page_T<float>(page, ptr, compare, value, upper);
+    break;
+  case scan_value_type::SVT_DOUBLE:
+    this->scan_page_T<double>(page, ptr, compare, value, upper);
+    break;
+  default:
+    page.count = 0;
+    break;
+  }
+}
+
+void ScanSession::store_page(Page& page, const byte* ptr)
+{
+  const size_t tail = page.tail ? this->tail_size() : 0;
+
+  page.hash = hash_page(ptr, tail);
+
+  // keep the whole page while it is dense, otherwise keep the values of the candidates only
+
+  const size_t size = this->value_size();
+  const size_t step = this->slot_step();
+
+  std::vector<byte> values;
+
+  page.whole = page.count * size >= SCAN_PAGE_SIZE / 2;
+  if (page.whole)
+  {
+    values.assign(ptr, ptr + SCAN_PAGE_SIZE + tail);
+  }
+  else
+  {
+    this->get_slots(page, m_slots);
+
+    values.reserve(page.count * size);
+
+    for (const auto slot : m_slots)
+    {
+      const byte* p = ptr + slot * step;
+      values.insert(values.end(), p, p + size);
+    }
+  }
+
+  page.values.swap(values); // release the capacity of the previous values
+}
+
+bool ScanSession::first_scan(
+  const scan_compare_type compare,
+  const ScanValue& value,
+  const ScanValue& upper,
+  const ulong state,
+  const ulong type,
+  const ulong protection)
+{
+  this->reset();
+
+  if (!m_process.ready())
+  {
+    return false;
+  }
+
+  switch (compare)
+  {
+  case scan_compare_type::SCT_UNKNOWN:
+  case scan_compare_type::SCT_EQUALS:
+  case scan_compare_type::SCT_GREATER:
+  case scan_compare_type::SCT_LESS:
+  case scan_compare_type::SCT_BETWEEN:
+    break;
+  default: // the relative comparisons require the previous values
+    return false;
+  }
+
+  const size_t n_slots = this->slot_count();
+  const size_t tail = this->tail_size();
+
+  std::vector<uint64> all_slots((n_slots + 63) / 64, ~0ULL);
+  if (n_slots % 64 != 0)
+  {
+    all_slots.back() = (1ULL << (n_slots % 64)) - 1;
+  }
+
+  // the slots of a page without its tail
+
+  std::vector<uint64> inner_slots(all_slots);
+  for (size_t slot = n_slots - tail; slot < n_slots; slot++)
+  {
+    inner_slots[slot / 64] &= ~(1ULL << (slot % 64));
+  }
+
+  std::vector<byte> buffer(SCAN_READ_SIZE + SCAN_PAGE_SIZE); // The room for the tail of the last page
+
+  for (const auto& range : coalesce_memories(m_process.get_memories(state, type, protection)))
+  {
+    const ulongptr end = range.end;
+
+    for (ulongptr address = range.begin; address < end; address += SCAN_READ_SIZE)
+    {
+      const size_t size = size_t(end - address < SCAN_READ_SIZE ? end - address : SCAN_READ_SIZE);
+
+      const bool read = read_memory(m_process.handle(), LPCVOID(address), buffer.data(), size, false);
+
+      for (size_t offset = 0; offset + SCAN_PAGE_SIZE <= size; offset += SCAN_PAGE_SIZE)
+      {
+        // the pages are read one by one if the whole chunk could not be read
+
+        if (!read && !read_memory(
+          m_process.handle(), LPCVOID(address + offset), buffer.data() + offset, SCAN_PAGE_SIZE, false))
+        {
+          continue;
+        }
+
+        // the tail is in the buffer if the next page was read with the page, otherwise it is read alone
+
+        const ulongptr next = address + offset + SCAN_PAGE_SIZE;
+
+        Page page;
+        page.address = address + offset;
+        page.tail = tail != 0 && next < end && ((read && offset + SCAN_PAGE_SIZE < size) ||
+          read_memory(m_process.handle(), LPCVOID(next), buffer.data() + offset + SCAN_PAGE_SIZE, tail, false));
+        page.count = page.tail ? n_slots : n_slots - tail;
+        page.bitmap = page.tail ? all_slots : inner_slots;
+        page.whole = true;
+
+        if (compare != scan_compare_type::SCT_UNKNOWN)
+        {
+          this->scan_page(page, buffer.data() + offset, compare, value, upper);
+        }
+
+        if (page.count == 0)
+        {
+          continue;
+        }
+
+        this->store_page(page, buffer.data() + offset);
+
+        m_count += page.count;
+        m_pages.push_back(std::move(page));
+      }
+    }
+  }
+
+  m_scanned = true;
+
+  return true;
+}
+
+bool ScanSession::next_scan(
+  const scan_compare_type compare, const ScanValue& value, const ScanValue& upper)
+{
+  if (!m_scanned || !m_process.ready() || compare == scan_compare_type::SCT_UNKNOWN)
+  {
+    return false;
+  }
+
+  const size_t tail = this->tail_size();
+
+  std::vector<byte> buffer(SCAN_READ_SIZE + SCAN_PAGE_SIZE); // The room for the tail of the last page
+
+  const size_t max_run = SCAN_READ_SIZE / SCAN_PAGE_SIZE;
+
+  for (size_t i = 0; i < m_pages.size();)
+  {
+    // read the consecutive pages at once
+
+    size_t n = 1;
+    while (i + n < m_pages.size() && n < max_run &&
+      m_pages[i + n].address == m_pages[i].address + n * SCAN_PAGE_SIZE) n++;
+
+    const bool read = read_memory(
+      m_process.handle(), LPCVOID(m_pages[i].address), buffer.data(), n * SCAN_PAGE_SIZE, false);
+
+    for (size_t j = 0; j < n; j++)
+    {
+      auto& page = m_pages[i + j];
+      byte* ptr = buffer.data() + j * SCAN_PAGE_SIZE;
+
+      if (!read && !read_memory(m_process.handle(), LPCVOID(page.address), ptr, SCAN_PAGE_SIZE, false))
+      {
+        page.count = 0;
+        continue;
+      }
+
+      // the tail is in the buffer if the next page was read with the page, otherwise it is read alone
+
+      if (page.tail && !(read && j + 1 < n) && !read_memory(
+        m_process.handle(), LPCVOID(page.address + SCAN_PAGE_SIZE), ptr + SCAN_PAGE_SIZE, tail, false))
+      {
+        page.tail = false;
+      }
+
+      // the page content is the same as the previous scan so all candidates share the result
+
+      if (hash_page(ptr, page.tail ? tail : 0) == page.hash)
+      {
+        switch (compare)
+        {
+        case scan_compare_type::SCT_UNCHANGED:
+          continue;
+        case scan_compare_type::SCT_CHANGED:
+        case scan_compare_type::SCT_INCREASED:
+        case scan_compare_type::SCT_DECREASED:
+          page.count = 0;
+          continue;
+        default:
+          break;
+        }
+      }
+
+      this->scan_page(page, ptr, compare, value, upper);
+
+      if (page.count != 0)
+      {
+        this->store_page(page, ptr);
+      }
+    }
+
+    i += n;
+  }
+
+  // drop the pages those have no candidate
+
+  m_pages.erase(std::remove_if(m_pages.begin(), m_pages.end(), [](const Page& page) -> bool
+  {
+    return page.count == 0;
+  }), m_pages.end());
+
+  m_count = 0;
+  for (const auto& page : m_pages) m_count += page.count;
+
+  return true;
+}
+
+} // namespace vu
@@ -0,0 +1,27 @@
+/**
+ * @file   memscan.h
+ * @author Vic P.
+ * @brief  Header for Memory Scanning
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+struct MemoryRange
+{
+  ulongptr begin;
+  ulongptr end;
+};
+
+/**
+ * Merge the adjacent committed regions into continuous ranges, so they are read by fewer and
+ * larger reads. The ranges are only for reading, the matches are still made in their regions.
+ * The guard and no-access regions are never merged since reading them always fails.
+ */
+std::vector<MemoryRange> coalesce_memories(const ProcessX::memories& memories);
+
+} // namespace vu
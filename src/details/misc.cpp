@@ -7,6 +7,9 @@
 #include "Vutils.h"
 #include "lazy.h"
 #include "defs.h"
+#include "pattern.h"
+
+#include <atomic>
 
 #if defined(_MSC_VER) || defined(__BCPLUSPLUS__) // LNK
 #include "shobjidl.h"
@@ -189,90 +192,233 @@ bool vuapi set_env_W(const std::wstring& name, const std::wstring& value)
   return SetEnvironmentVariableW(name.c_str(), value.c_str()) != FALSE;
 }
 
-typedef std::vector<std::pair<bool, byte>> TPattern;
+std::vector<size_t> find_pattern_A(
+  const Buffer& buffer, const std::string& pattern, const bool first_match_only)
+{
+  return find_pattern_A(buffer, Pattern(pattern), first_match_only);
+}
 
-const TPattern to_pattern(const std::string& buffer)
+std::vector<size_t> find_pattern_W(
+  const Buffer& buffer, const std::wstring& pattern, const bool first_match_only)
 {
-  TPattern result;
+  return find_pattern_W(buffer, Pattern(pattern), first_match_only);
+}
 
-  const auto l = vu::split_string_A(buffer, " ");
-  for (const auto& e : l)
-  {
-    auto v = TPattern::value_type(false, 0x00);
+std::vector<size_t> find_pattern_A(
+  const void* ptr, const size_t size, const std::string& pattern, const bool first_match_only)
+{
+  return find_pattern_A(ptr, size, Pattern(pattern), first_match_only);
+}
 
-    if (e.length() == 2 && isxdigit(e[0]) && isxdigit(e[1]))
-    {
-      v.first  = true;
-      v.second = (byte)strtoul(e.c_str(), nullptr, 16);
-    }
+std::vector<size_t> find_pattern_W(
+  const void* ptr, const size_t size, const std::wstring& pattern, const bool first_match_only)
+{
+  return find_pattern_W(ptr, size, Pattern(pattern), first_match_only);
+}
 
-    result.emplace_back(v);
-  }
+std::vector<size_t> find_pattern_A(
+  const Buffer& buffer, const Pattern& pattern, const bool first_match_only)
+{
+  return find_pattern_A(buffer.get_ptr(), buffer.get_size(), pattern, first_match_only);
+}
 
-  return result;
+std::vector<size_t> find_pattern_W(
+  const Buffer& buffer, const Pattern& pattern, const bool first_match_only)
+{
+  return find_pattern_A(buffer.get_ptr(), buffer.get_size(), pattern, first_match_only);
 }
 
 std::vector<size_t> find_pattern_A(
-  const Buffer& buffer, const std::string& pattern, const bool first_match_only)
+  const BufferView& view, const std::string& pattern, const bool first_match_only)
+{
+  return find_pattern_A(view, Pattern(pattern), first_match_only);
+}
+
+std::vector<size_t> find_pattern_W(
+  const BufferView& view, const std::wstring& pattern, const bool first_match_only)
+{
+  return find_pattern_W(view, Pattern(pattern), first_match_only);
+}
+
+std::vector<size_t> find_pattern_A(
+  const BufferView& view, const Pattern& pattern, const bool first_match_only)
+{
+  return find_pattern_A(view.get_ptr(), view.get_size(), pattern, first_match_only);
+}
+
+std::vector<size_t> find_pattern_W(
+  const BufferView& view, const Pattern& pattern, const bool first_match_only)
+{
+  return find_pattern_A(view.get_ptr(), view.get_size(), pattern, first_match_only);
+}
+
+std::vector<size_t> find_pattern_A(
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only)
 {
   std::vector<size_t> result;
 
-  if (buffer.get_ptr() == nullptr || pattern.empty())
+  if (ptr == nullptr || size == 0 || pattern.empty())
   {
     return result;
   }
 
-  const auto pointer = static_cast<const byte*>(buffer.get_ptr());
-  const size_t size = buffer.get_size();
+  const auto pointer = static_cast<const byte*>(ptr);
 
-  return find_pattern_A(pointer, size, pattern, first_match_only);
+  for (size_t i = 0; i < size;)
+  {
+    const size_t offset = find_pattern_first(pointer + i, size - i, pattern);
+    if (offset == -1)
+    {
+      break;
+    }
+
+    result.push_back(i + offset);
+
+    if (first_match_only)
+    {
+      break;
+    }
+
+    i += offset + 1;
+  }
+
+  return result;
 }
 
 std::vector<size_t> find_pattern_W(
-  const Buffer& buffer, const std::wstring& pattern, const bool first_match_only)
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only)
 {
-  const auto s = to_string_A(pattern);
-  return find_pattern_A(buffer, s, first_match_only);
+  return find_pattern_A(ptr, size, pattern, first_match_only);
 }
 
+/**
+ * The parallel scanning splits the match starts into chunks, each chunk is scanned by blocks and
+ * each block also reads the next `pattern.size() - 1` bytes, so the matches that cross the block
+ * boundaries are neither lost nor duplicated.
+ */
+
+static const size_t PARALLEL_SCAN_BLOCK_SIZE = 1 * MB;
+
 std::vector<size_t> find_pattern_A(
-  const void* ptr, const size_t size, const std::string& pattern, const bool first_match_only)
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only,
+  const size_t n_threads)
 {
   std::vector<size_t> result;
 
-  if (ptr == nullptr || size == 0 || pattern.empty())
+  if (ptr == nullptr || size == 0 || pattern.empty() || size < pattern.size())
   {
     return result;
   }
 
-  const auto patternn = to_pattern(pattern);
-  if (pattern.empty())
+  const auto pointer = static_cast<const byte*>(ptr);
+  const size_t n_starts = size - pattern.size() + 1;
+
+  size_t n_workers = n_threads;
+  if (n_workers == MAX_NTHREADS)
+  {
+    n_workers = std::thread::hardware_concurrency();
+  }
+
+  if (n_workers <= 1 || n_starts < 2 * PARALLEL_SCAN_BLOCK_SIZE)
   {
-    return result;
+    return find_pattern_A(ptr, size, pattern, first_match_only);
   }
 
-  const auto pointer = static_cast<const byte*>(ptr);
+  // more chunks than the workers to balance the load between them
 
-  for (size_t i = 0; i < size; i++)
+  size_t chunk_size = n_starts / (4 * n_workers);
+  if (chunk_size < PARALLEL_SCAN_BLOCK_SIZE)
   {
-    size_t j = 0;
+    chunk_size = PARALLEL_SCAN_BLOCK_SIZE;
+  }
+
+  const size_t n_chunks = (n_starts + chunk_size - 1) / chunk_size;
+
+  std::vector<std::vector<size_t>> chunk_results(n_chunks);
+
+  std::atomic<size_t> first(size_t(-1)); // The first match so far for the first match only mode
+  std::atomic<size_t> next(0);           // The next chunk to scan
 
-    for (j = 0; j < patternn.size(); j++)
+  // one task per worker that takes the chunks in turn, since the pool could stop waiting while
+  // there are still queued tasks
+
+  if (n_workers > n_chunks)
+  {
+    n_workers = n_chunks;
+  }
+
+  ThreadPool pool(n_workers);
+
+  for (size_t worker = 0; worker < n_workers; worker++)
+  {
+    pool.add_task([=, &pattern, &chunk_results, &first, &next]() -> void
     {
-      if (patternn[j].first && patternn[j].second != pointer[i + j])
+      for (size_t i = next++; i < n_chunks; i = next++)
       {
-        break;
-      }
-    }
+        auto& offsets = chunk_results[i];
 
-    if (j == patternn.size())
-    {
-      result.push_back(i);
+        const size_t begin = i * chunk_size;
+        const size_t end = begin + chunk_size < n_starts ? begin + chunk_size : n_starts;
 
-      if (first_match_only)
-      {
-        break;
+        for (size_t block = begin; block < end; block += PARALLEL_SCAN_BLOCK_SIZE)
+        {
+          // cancel the rest since the other chunk already matched before this block
+
+          if (first_match_only && first.load() < block)
+          {
+            break;
+          }
+
+          size_t block_end = block + PARALLEL_SCAN_BLOCK_SIZE;
+          if (block_end > end)
+          {
+            block_end = end;
+          }
+
+          const size_t block_size = block_end - block + pattern.size() - 1;
+
+          for (size_t j = 0; j < block_size;)
+          {
+            const size_t offset = find_pattern_first(pointer + block + j, block_size - j, pattern);
+            if (offset == -1)
+            {
+              break;
+            }
+
+            offsets.push_back(block + j + offset);
+
+            if (first_match_only)
+            {
+              break;
+            }
+
+            j += offset + 1;
+          }
+
+          if (first_match_only && !offsets.empty())
+          {
+            const size_t offset = offsets.front();
+            size_t expected = first.load();
+            while (offset < expected && !first.compare_exchange_weak(expected, offset));
+            break;
+          }
+        }
       }
+    });
+  }
+
+  pool.launch();
+
+  // the chunks are ordered so their results are concatenated in the sorted order
+
+  for (const auto& offsets : chunk_results)
+  {
+    result.insert(result.end(), offsets.begin(), offsets.end());
+
+    if (first_match_only && !result.empty())
+    {
+      result.resize(1);
+      break;
     }
   }
 
@@ -280,10 +426,76 @@ std::vector<size_t> find_pattern_A(
 }
 
 std::vector<size_t> find_pattern_W(
-  const void* ptr, const size_t size, const std::wstring& pattern, const bool first_match_only)
+  const void* ptr, const size_t size, const Pattern& pattern, const bool first_match_only,
+  const size_t n_threads)
+{
+  return find_pattern_A(ptr, size, pattern, first_match_only, n_threads);
+}
+
+/**
+ * The file is scanned through a sliding view of the file mapping, so the memory usage is bounded by
+ * the view size whatever the file size. The view offsets must be aligned to the allocation granularity.
+ */
+
+static const ulong PATTERN_FILE_VIEW_SIZE = 64 * 1024 * 1024;
+
+template <class file_mapping_t, class std_string_t>
+std::vector<uint64> find_pattern_in_file_T(
+  const std_string_t& file_path, const Pattern& pattern, const bool first_match_only)
+{
+  std::vector<uint64> result;
+
+  if (file_path.empty() || pattern.empty())
+  {
+    return result;
+  }
+
+  file_mapping_t file_mapping;
+
+  auto ret = file_mapping.create_within_file(
+    file_path, 0, 0,
+    fs_generic::FG_READ,
+    fs_share::FS_ALLACCESS,
+    fs_mode::FM_OPENEXISTING,
+    fs_attribute::FA_NORMAL,
+    page_protection::PP_READ_ONLY);
+  if (ret != VU_OK)
+  {
+    return result;
+  }
+
+  const uint64 file_size = file_mapping.get_file_size_ex();
+
+  PatternScanner scanner(pattern, first_match_only);
+
+  for (uint64 offset = 0; offset < file_size && !scanner.done(); offset += PATTERN_FILE_VIEW_SIZE)
+  {
+    const uint64 remaining = file_size - offset;
+    const ulong size = remaining < PATTERN_FILE_VIEW_SIZE ? ulong(remaining) : PATTERN_FILE_VIEW_SIZE;
+
+    auto ptr = file_mapping.view(
+      FileMappingX::desired_access::DA_READ, ulong(offset & 0xFFFFFFFF), ulong(offset >> 32), size);
+    if (ptr == nullptr)
+    {
+      break;
+    }
+
+    scanner.push(ptr, size, result);
+  }
+
+  return result;
+}
+
+std::vector<uint64> find_pattern_in_file_A(
+  const std::string& file_path, const Pattern& pattern, const bool first_match_only)
+{
+  return find_pattern_in_file_T<FileMappingA>(file_path, pattern, first_match_only);
+}
+
+std::vector<uint64> find_pattern_in_file_W(
+  const std::wstring& file_path, const Pattern& pattern, const bool first_match_only)
 {
-  const auto s = to_string_A(pattern);
-  return find_pattern_A(ptr, size, s, first_match_only);
+  return find_pattern_in_file_T<FileMappingW>(file_path, pattern, first_match_only);
 }
 
 std::string undecorate_cpp_symbol_A(const std::string& name, const ushort flags)
@@ -0,0 +1,214 @@
+/**
+ * @file   mpool.cpp
+ * @author Vic P.
+ * @brief  Implementation for Memory Pool
+ */
+
+#include "Vutils.h"
+
+#include <atomic>
+
+namespace vu
+{
+
+static const size_t POOL_MIN_CLASS_SIZE = 64;
+static const size_t POOL_N_CLASSES = 17; // The classes are 64 bytes to 4 MiB, the larger blocks are not cached
+static const size_t POOL_MAX_N_SHARDS = 64;
+
+/**
+ * The index of the smallest class that fits the size, the classes are the powers of two.
+ */
+
+static inline size_t pool_class_of(const size_t size)
+{
+  size_t index = 0;
+
+  for (size_t class_size = POOL_MIN_CLASS_SIZE; class_size < size && index < POOL_N_CLASSES; class_size <<= 1)
+  {
+    index++;
+  }
+
+  return index;
+}
+
+struct BufferPool::Shard
+{
+  std::mutex mutex;
+  std::vector<void*> blocks[POOL_N_CLASSES];
+  size_t bytes_cached;
+  uint64 hits;
+  uint64 misses;
+  int64  bytes_outstanding; // The blocks could be freed by other threads so it could be negative
+
+  Shard() : bytes_cached(0), hits(0), misses(0), bytes_outstanding(0) {}
+};
+
+struct BufferPool::Total
+{
+  std::atomic<size_t> bytes_cached; // The cached bytes of all shards, they are reserved before caching
+
+  Total() : bytes_cached(0) {}
+};
+
+BufferPool::BufferPool(const size_t max_cached_size)
+  : m_shards(nullptr), m_total(nullptr), m_n_shards(1), m_max_cached_size(max_cached_size)
+{
+  const size_t n_threads = std::thread::hardware_concurrency();
+
+  while (m_n_shards < n_threads && m_n_shards < POOL_MAX_N_SHARDS)
+  {
+    m_n_shards <<= 1;
+  }
+
+  m_shards = new Shard[m_n_shards];
+  m_total = new Total;
+}
+
+BufferPool::~BufferPool()
+{
+  this->trim();
+
+  delete[] m_shards;
+  delete m_total;
+}
+
+BufferPool::Shard& BufferPool::get_shard() const
+{
+  // the thread ids are the multiples of 4
+
+  return m_shards[(GetCurrentThreadId() >> 2) & (m_n_shards - 1)];
+}
+
+void* BufferPool::allocate(const size_t size, size_t& capacity)
+{
+  capacity = 0;
+
+  if (size == 0)
+  {
+    return nullptr;
+  }
+
+  auto& shard = this->get_shard();
+
+  const size_t index = pool_class_of(size);
+  const size_t block_size = index < POOL_N_CLASSES ? POOL_MIN_CLASS_SIZE << index : size;
+
+  if (index < POOL_N_CLASSES)
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto& blocks = shard.blocks[index];
+    if (!blocks.empty())
+    {
+      void* ptr = blocks.back();
+      blocks.pop_back();
+
+      shard.hits++;
+      shard.bytes_cached -= block_size;
+      m_total->bytes_cached -= block_size;
+      shard.bytes_outstanding += block_size;
+
+      capacity = block_size;
+
+      return ptr;
+    }
+  }
+
+  void* ptr = std::malloc(block_size);
+  if (ptr == nullptr)
+  {
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.misses++;
+    shard.bytes_outstanding += block_size;
+  }
+
+  capacity = block_size;
+
+  return ptr;
+}
+
+void BufferPool::deallocate(void* ptr, const size_t capacity)
+{
+  if (ptr == nullptr)
+  {
+    return;
+  }
+
+  auto& shard = this->get_shard();
+
+  const size_t index = pool_class_of(capacity);
+  const bool cacheable = index < POOL_N_CLASSES && (POOL_MIN_CLASS_SIZE << index) == capacity;
+
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    shard.bytes_outstanding -= capacity;
+
+    // the bytes are reserved in the total first, so the shards never cache more than the maximum together
+
+    size_t total = m_total->bytes_cached.load();
+    while (cacheable && total + capacity <= m_max_cached_size &&
+      !m_total->bytes_cached.compare_exchange_weak(total, total + capacity));
+
+    if (cacheable && total + capacity <= m_max_cached_size)
+    {
+      shard.blocks[index].push_back(ptr);
+      shard.bytes_cached += capacity;
+      return;
+    }
+  }
+
+  std::free(ptr);
+}
+
+void BufferPool::trim()
+{
+  for (size_t i = 0; i < m_n_shards; i++)
+  {
+    auto& shard = m_shards[i];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    for (auto& blocks : shard.blocks)
+    {
+      for (auto ptr : blocks)
+      {
+        std::free(ptr);
+      }
+
+      std::vector<void*>().swap(blocks);
+    }
+
+    m_total->bytes_cached -= shard.bytes_cached;
+    shard.bytes_cached = 0;
+  }
+}
+
+BufferPool::Statistics BufferPool::statistics() const
+{
+  Statistics result = { 0 };
+
+  int64 bytes_outstanding = 0;
+
+  for (size_t i = 0; i < m_n_shards; i++)
+  {
+    auto& shard = m_shards[i];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    result.hits += shard.hits;
+    result.misses += shard.misses;
+    result.bytes_cached += shard.bytes_cached;
+    bytes_outstanding += shard.bytes_outstanding;
+  }
+
+  result.bytes_outstanding = uint64(bytes_outstanding);
+
+  return result;
+}
+
+} // namespace vu
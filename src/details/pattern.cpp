@@ -0,0 +1,1032 @@
+/**
+ * @file   pattern.cpp
+ * @author Vic P.
+ * @brief  Implementation for Pattern Scanning
+ */
+
+#include "pattern.h"
+#include "simd.h"
+
+#include <deque>
+#include <algorithm>
+
+namespace vu
+{
+
+/**
+ * The approximate frequency of the bytes in the executable images and their data.
+ * Higher is more common, eg. 0x00 (padding), 0xFF, 0xCC (int3), 0x48 (REX.W), 0x8B (mov), etc.
+ */
+
+static const byte BYTE_FREQUENCIES[256] =
+{
+  255,  90,  60,  50,  70,  35,  30,  25,  60,  25,  40,  20,  30,  30,  20,  80, // 0x00
+   50,  20,  15,  12,  25,  40,  10,   8,  35,  10,   8,   8,  20,   8,   8,  10, // 0x10
+   90,  15,  15,  10,  90,  25,  10,  10,  50,  25,  10,  25,  25,  25,  40,  20, // 0x20
+   60,  35,  30,  40,  20,  20,  20,  15,  40,  30,  15,  20,  20,  15,  10,  10, // 0x30
+   70,  50,  25,  35,  70,  45,  30,  20, 150,  50,  10,  10,  80,  40,  25,  20, // 0x40
+   40,  20,  20,  30,  30,  40,  25,  25,  25,  15,  10,  20,  20,  20,  20,  25, // 0x50
+   20,  60,  20,  35,  35,  80,  30,  20,  30,  55,  10,  10,  45,  30,  60,  55, // 0x60
+   30,  10,  55,  55,  80,  55,  15,  15,  15,  15,   8,   8,  15,  10,  10,  20, // 0x70
+   40,  25,  10,  80,  45,  60,  10,  10,  25, 100,  15, 140,  10,  70,   8,  10, // 0x80
+   50,   5,   5,   5,   8,  10,   5,   5,   8,   8,   5,   5,   8,   5,   5,   5, // 0x90
+   10,   8,   5,   5,   5,   5,   5,   5,  15,   5,   8,   5,   5,   5,   5,   5, // 0xA0
+   10,   5,   5,   5,   5,   5,  15,  15,  25,  10,  15,   8,   5,   5,   8,  10, // 0xB0
+   50,  20,  15,  50,  15,  10,  20,  40,  25,  15,   5,   5, 120,   8,   8,   8, // 0xC0
+   20,  15,   8,  10,   5,   5,   5,   5,  15,   5,   5,   8,   5,   5,   5,   5, // 0xD0
+   20,  10,   8,   8,  10,   8,   8,   8,  80,  45,   5,  40,  35,  10,   8,  10, // 0xE0
+   40,  10,  10,  10,  10,  10,  20,  20,  40,  10,  10,  10,  15,  15,  40, 200, // 0xF0
+};
+
+/**
+ * Pattern
+ */
+
+Pattern::Pattern()
+{
+  this->prepare();
+}
+
+Pattern::Pattern(const std::string& pattern)
+{
+  this->compile(pattern);
+}
+
+Pattern::Pattern(const std::wstring& pattern)
+{
+  this->compile(pattern);
+}
+
+Pattern::Pattern(const void* ptr, const size_t size)
+{
+  this->compile(ptr, size);
+}
+
+Pattern::Pattern(const Pattern& right)
+{
+  *this = right;
+}
+
+Pattern::~Pattern()
+{
+}
+
+const Pattern& Pattern::operator=(const Pattern& right)
+{
+  if (this != &right)
+  {
+    m_values = right.m_values;
+    m_masks  = right.m_masks;
+    memcpy(m_anchors, right.m_anchors, sizeof(m_anchors));
+    memcpy(m_skips, right.m_skips, sizeof(m_skips));
+  }
+
+  return *this;
+}
+
+bool Pattern::operator==(const Pattern& right) const
+{
+  return m_values == right.m_values && m_masks == right.m_masks;
+}
+
+bool Pattern::operator!=(const Pattern& right) const
+{
+  return !(*this == right);
+}
+
+bool Pattern::compile(const std::string& pattern)
+{
+  return this->parse(pattern.c_str(), pattern.length());
+}
+
+bool Pattern::compile(const std::wstring& pattern)
+{
+  return this->parse(pattern.c_str(), pattern.length());
+}
+
+bool Pattern::compile(const void* ptr, const size_t size)
+{
+  m_values.clear();
+  m_masks.clear();
+
+  if (ptr != nullptr && size != 0)
+  {
+    m_values.assign(static_cast<const byte*>(ptr), static_cast<const byte*>(ptr) + size);
+    m_masks.assign(size, 0xFF);
+  }
+
+  this->prepare();
+
+  return !this->empty();
+}
+
+bool Pattern::empty() const
+{
+  return m_values.empty();
+}
+
+size_t Pattern::size() const
+{
+  return m_values.size();
+}
+
+const byte* Pattern::values() const
+{
+  return m_values.data();
+}
+
+const byte* Pattern::masks() const
+{
+  return m_masks.data();
+}
+
+const size_t* Pattern::anchors() const
+{
+  return m_anchors;
+}
+
+const size_t* Pattern::skips() const
+{
+  return m_skips;
+}
+
+template <typename char_t>
+static inline int hex_nibble(const char_t c)
+{
+  if (c >= '0' && c <= '9') return int(c - '0');
+  if (c >= 'a' && c <= 'f') return int(c - 'a' + 10);
+  if (c >= 'A' && c <= 'F') return int(c - 'A' + 10);
+  return -1;
+}
+
+template <typename char_t>
+static inline bool is_blank(const char_t c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+template <typename char_t>
+bool Pattern::parse(const char_t* ptr, const size_t length)
+{
+  m_values.clear();
+  m_masks.clear();
+
+  for (size_t i = 0; i < length;)
+  {
+    if (is_blank(ptr[i]))
+    {
+      i++;
+      continue;
+    }
+
+    size_t n = 0;
+    while (i + n < length && !is_blank(ptr[i + n])) n++;
+
+    const char_t* token = ptr + i;
+    i += n;
+
+    byte value = 0x00, mask = 0x00;
+
+    if (n == 2)
+    {
+      const int hi = hex_nibble(token[0]);
+      const int lo = hex_nibble(token[1]);
+      const bool valid_hi = hi != -1 || token[0] == '?';
+      const bool valid_lo = lo != -1 || token[1] == '?';
+      if (valid_hi && valid_lo)
+      {
+        if (hi != -1)
+        {
+          value |= byte(hi << 4);
+          mask  |= 0xF0;
+        }
+
+        if (lo != -1)
+        {
+          value |= byte(lo);
+          mask  |= 0x0F;
+        }
+      }
+    }
+
+    // the other tokens like `?`, `*`, etc are matched any byte
+
+    m_values.push_back(value);
+    m_masks.push_back(mask);
+  }
+
+  this->prepare();
+
+  return !this->empty();
+}
+
+void Pattern::prepare()
+{
+  const size_t length = m_values.size();
+
+  // anchors
+
+  m_anchors[0] = m_anchors[1] = -1;
+
+  for (size_t i = 0; i < length; i++)
+  {
+    if (m_masks[i] != 0xFF)
+    {
+      continue;
+    }
+
+    size_t& first  = m_anchors[0];
+    size_t& second = m_anchors[1];
+
+    if (first == -1 || BYTE_FREQUENCIES[m_values[i]] < BYTE_FREQUENCIES[m_values[first]])
+    {
+      second = first;
+      first  = i;
+    }
+    else if (second == -1 || BYTE_FREQUENCIES[m_values[i]] < BYTE_FREQUENCIES[m_values[second]])
+    {
+      second = i;
+    }
+  }
+
+  if (m_anchors[1] == -1)
+  {
+    m_anchors[1] = m_anchors[0];
+  }
+
+  // skips - the distance from the rightmost position (except the last) that can match a byte value
+
+  for (size_t c = 0; c < 256; c++)
+  {
+    m_skips[c] = length == 0 ? 1 : length;
+  }
+
+  for (size_t j = 0; j + 1 < length; j++)
+  {
+    const size_t skip = length - 1 - j;
+
+    if (m_masks[j] == 0x00)
+    {
+      for (size_t c = 0; c < 256; c++) m_skips[c] = skip;
+    }
+    else if (m_masks[j] == 0xFF)
+    {
+      m_skips[m_values[j]] = skip;
+    }
+    else
+    {
+      for (size_t c = 0; c < 256; c++)
+      {
+        if ((byte(c) & m_masks[j]) == m_values[j]) m_skips[c] = skip;
+      }
+    }
+  }
+}
+
+/**
+ * Scalar
+ */
+
+static inline bool verify_pattern_scalar(
+  const byte* ptr, const byte* values, const byte* masks, const size_t begin, const size_t end)
+{
+  for (size_t j = begin; j < end; j++)
+  {
+    if ((ptr[j] & masks[j]) != values[j])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static size_t find_pattern_scalar(const byte* ptr, const size_t size, const Pattern& pattern)
+{
+  const size_t length = pattern.size();
+  if (length == 0 || size < length)
+  {
+    return -1;
+  }
+
+  const auto values = pattern.values();
+  const auto masks  = pattern.masks();
+
+  const auto skips = pattern.skips();
+  const size_t last = length - 1;
+
+  for (size_t i = 0; i <= size - length;)
+  {
+    const byte c = ptr[i + last];
+
+    if ((c & masks[last]) == values[last] && verify_pattern_scalar(ptr + i, values, masks, 0, last))
+    {
+      return i;
+    }
+
+    i += skips[c];
+  }
+
+  return -1;
+}
+
+#ifdef VU_SIMD_X86
+
+/**
+ * SSE2
+ */
+
+VU_TARGET_SSE2 static inline bool verify_pattern_sse2(
+  const byte* ptr, const byte* values, const byte* masks, const size_t length)
+{
+  size_t j = 0;
+
+  for (; j + 16 <= length; j += 16)
+  {
+    const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + j));
+    const auto m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + j));
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + j));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(d, m), v)) != 0xFFFF)
+    {
+      return false;
+    }
+  }
+
+  return verify_pattern_scalar(ptr, values, masks, j, length);
+}
+
+VU_TARGET_SSE2 static size_t find_pattern_sse2(
+  const byte* ptr, const size_t size, const Pattern& pattern)
+{
+  const size_t length = pattern.size();
+  if (length == 0 || size < length)
+  {
+    return -1;
+  }
+
+  const auto values = pattern.values();
+  const auto masks  = pattern.masks();
+
+  const size_t a1 = pattern.anchors()[0];
+  const size_t a2 = pattern.anchors()[1];
+  const auto v1 = _mm_set1_epi8(char(values[a1]));
+  const auto v2 = _mm_set1_epi8(char(values[a2]));
+
+  const size_t n_starts = size - length + 1;
+
+  size_t i = 0;
+
+  for (; i + 16 <= n_starts; i += 16)
+  {
+    const auto d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i + a1));
+    const auto d2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i + a2));
+    uint32 candidates = uint32(_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(d1, v1), _mm_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const size_t offset = i + bit_scan_forward(candidates);
+      if (verify_pattern_sse2(ptr + offset, values, masks, length))
+      {
+        return offset;
+      }
+
+      candidates &= candidates - 1;
+    }
+  }
+
+  for (; i < n_starts; i++)
+  {
+    if (verify_pattern_scalar(ptr + i, values, masks, 0, length))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+/**
+ * AVX2
+ */
+
+VU_TARGET_AVX2 static inline bool verify_pattern_avx2(
+  const byte* ptr, const byte* values, const byte* masks, const size_t length)
+{
+  size_t j = 0;
+
+  for (; j + 32 <= length; j += 32)
+  {
+    const auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + j));
+    const auto m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + j));
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + j));
+    if (uint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(d, m), v))) != 0xFFFFFFFF)
+    {
+      return false;
+    }
+  }
+
+  return verify_pattern_scalar(ptr, values, masks, j, length);
+}
+
+VU_TARGET_AVX2 static size_t find_pattern_avx2(
+  const byte* ptr, const size_t size, const Pattern& pattern)
+{
+  const size_t length = pattern.size();
+  if (length == 0 || size < length)
+  {
+    return -1;
+  }
+
+  const auto values = pattern.values();
+  const auto masks  = pattern.masks();
+
+  const size_t a1 = pattern.anchors()[0];
+  const size_t a2 = pattern.anchors()[1];
+  const auto v1 = _mm256_set1_epi8(char(values[a1]));
+  const auto v2 = _mm256_set1_epi8(char(values[a2]));
+
+  const size_t n_starts = size - length + 1;
+
+  size_t i = 0;
+
+  for (; i + 32 <= n_starts; i += 32)
+  {
+    const auto d1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i + a1));
+    const auto d2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i + a2));
+    uint32 candidates = uint32(_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(d1, v1), _mm256_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const size_t offset = i + bit_scan_forward(candidates);
+      if (verify_pattern_avx2(ptr + offset, values, masks, length))
+      {
+        return offset;
+      }
+
+      candidates &= candidates - 1;
+    }
+  }
+
+  // The remaining starts are fewer than a vector so finish them by the narrower kernel
+
+  const size_t offset = find_pattern_sse2(ptr + i, size - i, pattern);
+  return offset == -1 ? -1 : i + offset;
+}
+
+#endif // VU_SIMD_X86
+
+/**
+ * Dispatcher
+ */
+
+typedef size_t (*fn_find_pattern_t)(const byte* ptr, const size_t size, const Pattern& pattern);
+
+static fn_find_pattern_t select_find_pattern_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return find_pattern_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return find_pattern_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return find_pattern_scalar;
+}
+
+size_t find_pattern_first(const byte* ptr, const size_t size, const Pattern& pattern)
+{
+  if (ptr == nullptr || size == 0 || pattern.empty())
+  {
+    return -1;
+  }
+
+  // The vectorized kernels need at least a fully-specified byte to look for the candidates
+
+  if (pattern.anchors()[0] == -1)
+  {
+    return find_pattern_scalar(ptr, size, pattern);
+  }
+
+  static const fn_find_pattern_t fn = select_find_pattern_kernel();
+
+  return fn(ptr, size, pattern);
+}
+
+/**
+ * PatternSet
+ */
+
+static const size_t MAX_PATTERN_KEY_SIZE = 8;
+
+static const uint32 PATTERN_STATE_OUTPUT = 0x80000000;
+static const uint32 PATTERN_STATE_MASK   = 0x7FFFFFFF;
+
+PatternSet::PatternSet() : m_max_key_end(0), m_ready(false)
+{
+}
+
+PatternSet::PatternSet(const std::vector<Pattern>& patterns) : m_max_key_end(0), m_ready(false)
+{
+  for (const auto& pattern : patterns)
+  {
+    this->add(pattern);
+  }
+
+  this->compile();
+}
+
+PatternSet::~PatternSet()
+{
+}
+
+size_t PatternSet::add(const Pattern& pattern)
+{
+  m_patterns.push_back(pattern);
+  m_ready = false;
+  return m_patterns.size() - 1;
+}
+
+void PatternSet::clear()
+{
+  m_patterns.clear();
+  m_key_offsets.clear();
+  m_key_sizes.clear();
+  m_no_key_ids.clear();
+  m_transitions.clear();
+  m_output_links.clear();
+  m_output_begins.clear();
+  m_output_ids.clear();
+  m_max_key_end = 0;
+  m_ready = false;
+}
+
+bool PatternSet::empty() const
+{
+  return m_patterns.empty();
+}
+
+bool PatternSet::ready() const
+{
+  return m_ready;
+}
+
+size_t PatternSet::count() const
+{
+  return m_patterns.size();
+}
+
+const Pattern& PatternSet::get(const size_t id) const
+{
+  if (id >= m_patterns.size())
+  {
+    throw "pattern id is out of range";
+  }
+
+  return m_patterns[id];
+}
+
+/**
+ * Select the key of a pattern that is the least likely window of its fully-specified bytes.
+ * The likelihood of a byte is approximated by its frequency in the executable images.
+ */
+
+static void select_pattern_key(const Pattern& pattern, size_t& key_offset, size_t& key_size)
+{
+  key_offset = 0;
+  key_size = 0;
+
+  const auto masks  = pattern.masks();
+  const auto values = pattern.values();
+  const size_t length = pattern.size();
+
+  double best = 0.;
+
+  for (size_t i = 0; i < length;)
+  {
+    if (masks[i] != 0xFF)
+    {
+      i++;
+      continue;
+    }
+
+    size_t end = i;
+    while (end < length && masks[end] == 0xFF) end++;
+
+    const size_t n = end - i < MAX_PATTERN_KEY_SIZE ? end - i : MAX_PATTERN_KEY_SIZE;
+
+    for (size_t j = i; j + n <= end; j++)
+    {
+      double score = 0.;
+      for (size_t k = j; k < j + n; k++)
+      {
+        score += std::log((BYTE_FREQUENCIES[values[k]] + 1) / 256.);
+      }
+
+      if (key_size == 0 || score < best)
+      {
+        best = score;
+        key_offset = j;
+        key_size = n;
+      }
+    }
+
+    i = end;
+  }
+}
+
+bool PatternSet::compile()
+{
+  const size_t n_patterns = m_patterns.size();
+
+  m_key_offsets.assign(n_patterns, 0);
+  m_key_sizes.assign(n_patterns, 0);
+  m_no_key_ids.clear();
+  m_max_key_end = 0;
+  m_ready = false;
+
+  // build the trie of the keys
+
+  const uint32 NONE = uint32(-1);
+
+  m_transitions.assign(256, NONE);
+  std::vector<std::vector<size_t>> outputs(1);
+
+  for (size_t id = 0; id < n_patterns; id++)
+  {
+    const auto& pattern = m_patterns[id];
+    if (pattern.empty())
+    {
+      continue;
+    }
+
+    size_t& key_offset = m_key_offsets[id];
+    size_t& key_size = m_key_sizes[id];
+
+    select_pattern_key(pattern, key_offset, key_size);
+
+    if (key_size == 0)
+    {
+      m_no_key_ids.push_back(id);
+      continue;
+    }
+
+    if (m_max_key_end < key_offset + key_size)
+    {
+      m_max_key_end = key_offset + key_size;
+    }
+
+    uint32 state = 0;
+
+    for (size_t i = key_offset; i < key_offset + key_size; i++)
+    {
+      const size_t index = state * 256 + pattern.values()[i];
+      if (m_transitions[index] == NONE)
+      {
+        m_transitions[index] = uint32(outputs.size());
+        outputs.resize(outputs.size() + 1);
+        m_transitions.resize(m_transitions.size() + 256, NONE);
+      }
+
+      state = m_transitions[index];
+    }
+
+    outputs[state].push_back(id);
+  }
+
+  const size_t n_states = outputs.size();
+  if (n_states > PATTERN_STATE_MASK)
+  {
+    return false;
+  }
+
+  // build the automaton by the breadth-first traversal, the transitions of a state are completed
+  // from the transitions of its failure state which is shallower so it was already completed
+
+  std::vector<uint32> failures(n_states, 0);
+  m_output_links.assign(n_states, 0);
+
+  std::deque<uint32> states;
+
+  for (size_t c = 0; c < 256; c++)
+  {
+    auto& next = m_transitions[c];
+    if (next == NONE)
+    {
+      next = 0;
+    }
+    else
+    {
+      states.push_back(next);
+    }
+  }
+
+  while (!states.empty())
+  {
+    const uint32 state = states.front();
+    states.pop_front();
+
+    const uint32 failure = failures[state];
+
+    for (size_t c = 0; c < 256; c++)
+    {
+      auto& next = m_transitions[state * 256 + c];
+      const uint32 fallback = m_transitions[failure * 256 + c];
+
+      if (next == NONE)
+      {
+        next = fallback;
+        continue;
+      }
+
+      failures[next] = fallback;
+      m_output_links[next] = outputs[fallback].empty() ? m_output_links[fallback] : fallback;
+      states.push_back(next);
+    }
+  }
+
+  // flatten the outputs and flag the transitions that lead to the states having outputs
+
+  m_output_begins.assign(n_states + 1, 0);
+  m_output_ids.clear();
+
+  for (size_t state = 0; state < n_states; state++)
+  {
+    m_output_begins[state] = m_output_ids.size();
+    m_output_ids.insert(m_output_ids.end(), outputs[state].begin(), outputs[state].end());
+  }
+
+  m_output_begins[n_states] = m_output_ids.size();
+
+  for (auto& next : m_transitions)
+  {
+    if (!outputs[next].empty() || m_output_links[next] != 0)
+    {
+      next |= PATTERN_STATE_OUTPUT;
+    }
+  }
+
+  m_ready = true;
+
+  return true;
+}
+
+bool PatternSet::scan(const void* ptr, const size_t size, THits& hits, const bool first_match_only) const
+{
+  hits.clear();
+
+  if (!m_ready)
+  {
+    return false;
+  }
+
+  if (ptr == nullptr || size == 0)
+  {
+    return true;
+  }
+
+  const auto bytes = static_cast<const byte*>(ptr);
+
+  // the patterns that have no key are scanned one by one
+
+  for (const auto id : m_no_key_ids)
+  {
+    for (size_t i = 0; i < size;)
+    {
+      const size_t offset = find_pattern_first(bytes + i, size - i, m_patterns[id]);
+      if (offset == -1)
+      {
+        break;
+      }
+
+      hits.push_back(THit(id, i + offset));
+
+      if (first_match_only)
+      {
+        break;
+      }
+
+      i += offset + 1;
+    }
+  }
+
+  // the others are located by their keys in a single pass then verified entirely
+
+  if (m_max_key_end != 0)
+  {
+    size_t first = -1;
+
+    if (first_match_only)
+    {
+      for (const auto& hit : hits) if (hit.second < first) first = hit.second;
+    }
+
+    const auto transitions = m_transitions.data();
+
+    uint32 state = 0;
+
+    for (size_t i = 0; i < size; i++)
+    {
+      const uint32 next = transitions[state * 256 + bytes[i]];
+      state = next & PATTERN_STATE_MASK;
+
+      if ((next & PATTERN_STATE_OUTPUT) == 0)
+      {
+        continue;
+      }
+
+      // any key ends from here belongs to a pattern that starts after the first hit
+
+      if (first != -1 && i + 1 >= m_max_key_end && i + 1 - m_max_key_end > first)
+      {
+        break;
+      }
+
+      const size_t key_end = i + 1;
+
+      uint32 output = m_output_begins[state] != m_output_begins[state + 1] ? state : m_output_links[state];
+
+      for (; output != 0; output = m_output_links[output])
+      {
+        for (size_t j = m_output_begins[output]; j < m_output_begins[output + 1]; j++)
+        {
+          const size_t id = m_output_ids[j];
+          const size_t n = m_key_offsets[id] + m_key_sizes[id];
+          if (key_end < n)
+          {
+            continue;
+          }
+
+          const auto& pattern = m_patterns[id];
+          const size_t offset = key_end - n;
+          if (offset + pattern.size() > size)
+          {
+            continue;
+          }
+
+          if (!verify_pattern_scalar(bytes + offset, pattern.values(), pattern.masks(), 0, pattern.size()))
+          {
+            continue;
+          }
+
+          hits.push_back(THit(id, offset));
+
+          if (first_match_only && offset < first)
+          {
+            first = offset;
+          }
+        }
+      }
+    }
+  }
+
+  // report the hits in the order of the offsets
+
+  std::sort(hits.begin(), hits.end(), [](const THit& a, const THit& b) -> bool
+  {
+    return a.second != b.second ? a.second < b.second : a.first < b.first;
+  });
+
+  if (first_match_only && hits.size() > 1)
+  {
+    hits.resize(1);
+  }
+
+  return true;
+}
+
+bool PatternSet::scan(const BufferView& view, THits& hits, const bool first_match_only) const
+{
+  return this->scan(view.get_ptr(), view.get_size(), hits, first_match_only);
+}
+
+/**
+ * PatternScanner
+ */
+
+PatternScanner::PatternScanner(const Pattern& pattern, const bool first_match_only)
+  : m_pattern(pattern), m_first_match_only(first_match_only), m_done(false), m_position(0)
+{
+}
+
+PatternScanner::~PatternScanner()
+{
+}
+
+void PatternScanner::reset()
+{
+  m_done = false;
+  m_position = 0;
+  m_tail.clear();
+}
+
+bool PatternScanner::done() const
+{
+  return m_done;
+}
+
+uint64 PatternScanner::position() const
+{
+  return m_position;
+}
+
+const Pattern& PatternScanner::pattern() const
+{
+  return m_pattern;
+}
+
+bool PatternScanner::push(const void* ptr, const size_t size, std::vector<uint64>& offsets)
+{
+  if (m_pattern.empty() || (ptr == nullptr && size != 0))
+  {
+    return false;
+  }
+
+  if (size == 0 || m_done)
+  {
+    return true;
+  }
+
+  const auto bytes = static_cast<const byte*>(ptr);
+  const size_t length = m_pattern.size();
+  const size_t n_tail = m_tail.size();
+
+  // the matches that start in the tail of the previous chunks and end in this chunk
+
+  if (n_tail != 0)
+  {
+    const size_t n_head = size < length - 1 ? size : length - 1;
+
+    m_joint.assign(m_tail.begin(), m_tail.end());
+    m_joint.insert(m_joint.end(), bytes, bytes + n_head);
+
+    for (size_t i = 0; i < n_tail;)
+    {
+      const size_t offset = find_pattern_first(m_joint.data() + i, m_joint.size() - i, m_pattern);
+      if (offset == -1 || i + offset >= n_tail)
+      {
+        break;
+      }
+
+      offsets.push_back(m_position - n_tail + i + offset);
+
+      if (m_first_match_only)
+      {
+        m_done = true;
+        break;
+      }
+
+      i += offset + 1;
+    }
+  }
+
+  // the matches that are entirely in this chunk
+
+  for (size_t i = 0; i < size && !m_done;)
+  {
+    const size_t offset = find_pattern_first(bytes + i, size - i, m_pattern);
+    if (offset == -1)
+    {
+      break;
+    }
+
+    offsets.push_back(m_position + i + offset);
+
+    if (m_first_match_only)
+    {
+      m_done = true;
+      break;
+    }
+
+    i += offset + 1;
+  }
+
+  m_position += size;
+
+  // keep the last `length - 1` bytes that could be the beginning of a match in the next chunks
+
+  if (size >= length - 1)
+  {
+    m_tail.assign(bytes + size - (length - 1), bytes + size);
+  }
+  else
+  {
+    m_tail.insert(m_tail.end(), bytes, bytes + size);
+    if (m_tail.size() > length - 1)
+    {
+      m_tail.erase(m_tail.begin(), m_tail.end() - (length - 1));
+    }
+  }
+
+  return true;
+}
+
+} // namespace vu
@@ -0,0 +1,20 @@
+/**
+ * @file   pattern.h
+ * @author Vic P.
+ * @brief  Header for Pattern Scanning
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+/**
+ * Find the first occurrence of a pattern in a memory region.
+ * @return The offset of the first match or -1 if not found.
+ */
+size_t find_pattern_first(const byte* ptr, const size_t size, const Pattern& pattern);
+
+} // namespace vu
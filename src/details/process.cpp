@@ -6,10 +6,13 @@
 
 #include "Vutils.h"
 #include "lazy.h"
+#include "memscan.h"
 
 #include <cassert>
 #include <cmath>
+#include <atomic>
 #include <thread>
+#include <condition_variable>
 
 #include <tlhelp32.h>
 
@@ -1270,10 +1273,55 @@ const ProcessX::memories& ProcessX::get_memories(
   return m_memories;
 }
 
+/**
+ * The memory scanning pipeline.
+ * The adjacent regions are merged into ranges, then the ranges are split into blocks those are
+ * distributed to the pipes. Each pipe has a reader that reads the blocks into its double buffers
+ * and a scanner that scans the filled buffers, so the reading of a block is overlapped with the
+ * scanning of the previous one, and the buffers are reused for all blocks. Each block also reads
+ * the next `pattern.size() - 1` bytes of its range, so the matches that cross the block boundaries
+ * are neither lost nor duplicated. The block is scanned as the pieces, one per region it overlaps,
+ * so a match never crosses the regions as the reads do. If a block could not be read at once, the
+ * pages of each piece are read one by one and the runs of the readable pages are scanned instead.
+ */
+
+static const size_t SCAN_MEMORY_BLOCK_SIZE = 4 * 1024 * 1024;
+static const size_t SCAN_MEMORY_PAGE_SIZE  = 0x1000;
+
+struct ScanMemoryBlock
+{
+  ulongptr address;
+  size_t size;
+  size_t region; // The index of the first region those overlap the block
+};
+
+struct ScanMemoryPiece
+{
+  size_t offset;
+  size_t size;
+};
+
+struct ScanMemoryPipe
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<byte> buffers[2];
+  std::vector<ScanMemoryPiece> pieces[2];
+  const byte* ptrs[2];
+  size_t indices[2]; // The index of the block in the buffer, -1 if the buffer is free
+  bool finished;
+
+  ScanMemoryPipe() : finished(false)
+  {
+    ptrs[0] = ptrs[1] = nullptr;
+    indices[0] = indices[1] = -1;
+  }
+};
+
 bool process_scan_memory(
   std::vector<size_t>& addresses,
   ProcessX& process,
-  const std::wstring& pattern,
+  const Pattern& pattern,
   const std::pair<byte*, ulong>& module,
   const bool first_match_only,
   const ulong state = DEF_SM_STATE,
@@ -1287,6 +1335,10 @@ bool process_scan_memory(
     return false;
   }
 
+  // split the merged ranges of the adjacent regions into the blocks
+
+  ProcessX::memories memories;
+
   for (auto& mem : process.get_memories(state, type, protection))
   {
     if (module.first != nullptr && module.second != 0)
@@ -1297,32 +1349,297 @@ bool process_scan_memory(
       }
     }
 
-    void*  ptr = mem.BaseAddress;
-    size_t num = mem.RegionSize;
+    memories.push_back(mem);
+  }
+
+  std::vector<ScanMemoryBlock> blocks;
+
+  const auto region_begin = [&](size_t i) -> ulongptr
+  {
+    return ulongptr(memories[i].BaseAddress);
+  };
+
+  const auto region_end = [&](size_t i) -> ulongptr
+  {
+    return ulongptr(memories[i].BaseAddress) + ulongptr(memories[i].RegionSize);
+  };
+
+  size_t region = 0;
 
-    Buffer remote_copied_mem_block;
-    if (process.pid() != GetCurrentProcessId())
+  for (const auto& range : coalesce_memories(memories))
+  {
+    const ulongptr end = range.end;
+
+    for (ulongptr address = range.begin; address < end; address += SCAN_MEMORY_BLOCK_SIZE)
     {
-      remote_copied_mem_block.resize(mem.RegionSize);
-      bool ret = process.read_memory(ulongptr(mem.BaseAddress), remote_copied_mem_block);
-      if (!ret)
+      ScanMemoryBlock block;
+      block.address = address;
+      block.size = size_t(end - address);
+
+      const size_t size = SCAN_MEMORY_BLOCK_SIZE + pattern.size() - 1;
+      if (block.size > size)
       {
-        continue;
+        block.size = size;
+      }
+
+      // the regions are in the ascending order of the addresses as the blocks are
+
+      while (region < memories.size() && region_end(region) <= address)
+      {
+        region++;
       }
 
-      ptr = remote_copied_mem_block.get_ptr();
-      num = remote_copied_mem_block.get_size();
+      block.region = region;
+
+      blocks.push_back(block);
     }
+  }
+
+  if (blocks.empty())
+  {
+    return true;
+  }
+
+  // run the pipes
+
+  const HANDLE hp = process.handle();
+  const bool local = process.pid() == GetCurrentProcessId();
+
+  size_t n_pipes = std::thread::hardware_concurrency() / 2;
+  if (n_pipes == 0)
+  {
+    n_pipes = 1;
+  }
+
+  if (n_pipes > blocks.size())
+  {
+    n_pipes = blocks.size();
+  }
+
+  std::vector<ScanMemoryPipe> pipes(n_pipes);
+  std::vector<std::vector<size_t>> results(blocks.size());
+
+  std::atomic<size_t> next(0);
+  std::atomic<size_t> first(size_t(-1)); // The first matched address for the first match only mode
+
+  // the pool may report that it is done while a task is not picked yet, so the tasks count themselves
+
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  size_t n_done = 0;
+
+  const auto done = [&]() -> void
+  {
+    std::lock_guard<std::mutex> lock(done_mutex);
+    n_done++;
+    done_cv.notify_all(); // under the lock, the waiter owns the condition variable
+  };
+
+  ThreadPool pool(2 * n_pipes);
+
+  // the scanners are added before the readers, a scanner waits on its pipe until the reader finishes so
+  // the pool cannot run out of the active tasks before all of them are added
 
-    auto offsets = find_pattern_W(ptr, num, pattern, first_match_only);
-    if (!offsets.empty())
+  for (auto& pipe : pipes)
+  {
+    auto* ptr_pipe = &pipe;
+
+    pool.add_task([=, &blocks, &results, &pattern, &first, &done]() -> void
     {
-      for (auto& offset : offsets) offset += ulongptr(mem.BaseAddress);
-      addresses.insert(addresses.end(), offsets.begin(), offsets.end());
-    }
+      auto& pipe = *ptr_pipe;
+
+      for (size_t slot = 0;; slot ^= 1)
+      {
+        size_t index = -1;
+        const byte* ptr = nullptr;
+
+        {
+          std::unique_lock<std::mutex> lock(pipe.mutex);
+          pipe.cv.wait(lock, [&]() { return pipe.indices[slot] != -1 || pipe.finished; });
+          index = pipe.indices[slot];
+          ptr = pipe.ptrs[slot];
+        }
+
+        // the buffers are filled in turn so the pipe is done if the next one is still free
+
+        if (index == -1)
+        {
+          break;
+        }
+
+        const auto& block = blocks[index];
+
+        auto& offsets = results[index];
+
+        for (const auto& piece : pipe.pieces[slot])
+        {
+          auto matches = find_pattern_A(ptr + piece.offset, piece.size, pattern, first_match_only);
+          for (auto& offset : matches) offsets.push_back(block.address + piece.offset + offset);
+
+          if (first_match_only && !offsets.empty())
+          {
+            break;
+          }
+        }
+
+        if (first_match_only && !offsets.empty())
+        {
+          size_t expected = first.load();
+          while (offsets.front() < expected && !first.compare_exchange_weak(expected, offsets.front()));
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(pipe.mutex);
+          pipe.indices[slot] = -1;
+        }
+
+        pipe.cv.notify_all();
+      }
+
+      done();
+    });
+  }
+
+  for (auto& pipe : pipes)
+  {
+    auto* ptr_pipe = &pipe;
+
+    pool.add_task([=, &memories, &blocks, &next, &first, &done]() -> void
+    {
+      auto& pipe = *ptr_pipe;
+
+      for (size_t slot = 0;;)
+      {
+        const size_t index = next++;
+        if (index >= blocks.size())
+        {
+          break;
+        }
+
+        // the blocks are in the ascending order of the addresses so the rest are cancelled
+
+        const auto& block = blocks[index];
+        if (first_match_only && first.load() < block.address)
+        {
+          break;
+        }
+
+        {
+          std::unique_lock<std::mutex> lock(pipe.mutex);
+          pipe.cv.wait(lock, [&]() { return pipe.indices[slot] == -1; });
+        }
+
+        const byte* ptr = reinterpret_cast<const byte*>(block.address);
+
+        auto& pieces = pipe.pieces[slot];
+        pieces.clear();
+
+        bool read = true;
+
+        if (!local)
+        {
+          auto& buffer = pipe.buffers[slot];
+          if (buffer.size() < block.size)
+          {
+            buffer.resize(block.size);
+          }
+
+          ptr = buffer.data();
+
+          read = read_memory(hp, LPCVOID(block.address), buffer.data(), block.size, false);
+        }
+
+        // the pieces are the parts of the regions in the block, so the matches stay in their regions
+
+        const ulongptr block_end = block.address + block.size;
+
+        for (size_t i = block.region; i < memories.size() && region_begin(i) < block_end; i++)
+        {
+          const ulongptr begin = region_begin(i) > block.address ? region_begin(i) : block.address;
+          const ulongptr end = region_end(i) < block_end ? region_end(i) : block_end;
+          if (begin >= end)
+          {
+            continue;
+          }
+
+          if (read)
+          {
+            ScanMemoryPiece piece = { size_t(begin - block.address), size_t(end - begin) };
+            pieces.push_back(piece);
+            continue;
+          }
+
+          // the pages are read one by one and the adjacent readable pages are joined into a piece
+
+          bool joined = false;
+
+          for (ulongptr address = begin; address < end; address += SCAN_MEMORY_PAGE_SIZE)
+          {
+            const size_t offset = size_t(address - block.address);
+            const size_t n = end - address < SCAN_MEMORY_PAGE_SIZE ? size_t(end - address) : SCAN_MEMORY_PAGE_SIZE;
+
+            if (!read_memory(hp, LPCVOID(address), pipe.buffers[slot].data() + offset, n, false))
+            {
+              joined = false;
+              continue;
+            }
+
+            if (joined)
+            {
+              pieces.back().size += n;
+            }
+            else
+            {
+              ScanMemoryPiece piece = { offset, n };
+              pieces.push_back(piece);
+              joined = true;
+            }
+          }
+        }
+
+        if (pieces.empty())
+        {
+          continue;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(pipe.mutex);
+          pipe.ptrs[slot] = ptr;
+          pipe.indices[slot] = index;
+        }
+
+        pipe.cv.notify_all();
+
+        slot ^= 1;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(pipe.mutex);
+        pipe.finished = true;
+      }
+
+      pipe.cv.notify_all();
+
+      done();
+    });
+  }
+
+  pool.launch();
+
+  {
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done_cv.wait(lock, [&]() { return n_done == 2 * n_pipes; });
+  }
+
+  // the blocks are ordered so their results are concatenated in the ascending order
+
+  for (const auto& offsets : results)
+  {
+    addresses.insert(addresses.end(), offsets.begin(), offsets.end());
 
     if (first_match_only && !addresses.empty())
     {
+      addresses.resize(1);
       break;
     }
   }
@@ -1521,6 +1838,19 @@ bool ProcessA::scan_memory(
   const ulong state,
   const ulong type,
   const ulong protection)
+{
+  return this->scan_memory(
+    addresses, Pattern(pattern), module_name, first_match_only, state, type, protection);
+}
+
+bool ProcessA::scan_memory(
+  std::vector<size_t>& addresses,
+  const Pattern& pattern,
+  const std::string& module_name,
+  const bool first_match_only,
+  const ulong state,
+  const ulong type,
+  const ulong protection)
 {
   if (!m_attached)
   {
@@ -1545,7 +1875,7 @@ bool ProcessA::scan_memory(
   }
 
   return process_scan_memory(
-    addresses, *this, to_string_W(pattern), module, first_match_only, state, type, protection);
+    addresses, *this, pattern, module, first_match_only, state, type, protection);
 }
 
 #pragma pop_macro("MODULEENTRY32")
@@ -1738,6 +2068,19 @@ bool ProcessW::scan_memory(
   const ulong state,
   const ulong type,
   const ulong protection)
+{
+  return this->scan_memory(
+    addresses, Pattern(pattern), module_name, first_match_only, state, type, protection);
+}
+
+bool ProcessW::scan_memory(
+  std::vector<size_t>& addresses,
+  const Pattern& pattern,
+  const std::wstring& module_name,
+  const bool first_match_only,
+  const ulong state,
+  const ulong type,
+  const ulong protection)
 {
   if (!m_attached)
   {
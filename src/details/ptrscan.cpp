@@ -0,0 +1,432 @@
+/**
+ * @file   ptrscan.cpp
+ * @author Vic P.
+ * @brief  Implementation for Pointer Scanner
+ */
+
+#include "Vutils.h"
+#include "memscan.h"
+
+#include <atomic>
+#include <algorithm>
+
+namespace vu
+{
+
+static const size_t POINTER_SCAN_PAGE_SIZE  = 0x1000;
+static const size_t POINTER_SCAN_BLOCK_SIZE = 0x100000; // The size of a read, 256 pages
+
+struct PointerScanner::Context
+{
+  size_t max_level;
+  ulong  max_offset;
+  size_t max_count;
+  std::atomic<size_t> count;
+};
+
+/**
+ * Run the jobs in parallel, each worker takes the next job until there is no job left.
+ * A new pool is used for each run, and there are never more tasks than the workers of the pool,
+ * so every task is handed directly to an idle worker and `launch` waits for all of them.
+ */
+
+template <typename Fn>
+static void run_jobs(const size_t n_jobs, size_t n_workers, Fn fn)
+{
+  if (n_workers == MAX_NTHREADS)
+  {
+    n_workers = std::thread::hardware_concurrency();
+  }
+
+  if (n_workers > n_jobs)
+  {
+    n_workers = n_jobs;
+  }
+
+  if (n_workers == 0)
+  {
+    n_workers = 1;
+  }
+
+  std::atomic<size_t> next(0);
+
+  ThreadPool pool(n_workers);
+
+  for (size_t i = 0; i < n_workers; i++)
+  {
+    pool.add_task([&]() -> void
+    {
+      for (size_t job = next++; job < n_jobs; job = next++)
+      {
+        fn(job);
+      }
+    });
+  }
+
+  pool.launch();
+}
+
+PointerScanner::PointerScanner(ProcessX& process) : LastError(), m_process(process), m_pointer_size(0)
+{
+}
+
+PointerScanner::~PointerScanner()
+{
+}
+
+void PointerScanner::reset()
+{
+  std::vector<Pointer>().swap(m_pointers);
+  std::vector<Image>().swap(m_images);
+  std::vector<ulongptr>().swap(m_blocks);
+}
+
+size_t PointerScanner::count() const
+{
+  return m_pointers.size();
+}
+
+const PointerScanner::Image* PointerScanner::find_image(const ulongptr address) const
+{
+  auto it = std::upper_bound(m_images.cbegin(), m_images.cend(), address,
+    [](const ulongptr address, const Image& image) -> bool
+  {
+    return address < image.begin;
+  });
+
+  if (it == m_images.cbegin() || address >= (--it)->end)
+  {
+    return nullptr;
+  }
+
+  return &*it;
+}
+
+ulongptr PointerScanner::location(const Pointer& pointer) const
+{
+  const size_t n_slots = POINTER_SCAN_BLOCK_SIZE / m_pointer_size;
+  return m_blocks[pointer.slot / n_slots] + ulongptr(pointer.slot % n_slots) * m_pointer_size;
+}
+
+bool PointerScanner::snapshot(const size_t n_threads)
+{
+  this->reset();
+
+  if (!m_process.ready())
+  {
+    return false;
+  }
+
+  const size_t pointer_size = size_t(m_process.bit());
+  if (pointer_size > sizeof(ulongptr))
+  {
+    m_last_error_code = ERROR_NOT_SUPPORTED;
+    return false;
+  }
+
+  // the readable regions, and the module images those are merged by their allocation bases
+
+  ProcessX::memories memories;
+
+  for (const auto& mem : m_process.get_memories(MEM_COMMIT, MEM_ALL_TYPE, DEF_SM_PROTECTION))
+  {
+    if ((mem.Protect & (PAGE_GUARD | PAGE_NOACCESS)) != 0)
+    {
+      continue;
+    }
+
+    memories.push_back(mem);
+
+    if (mem.Type != MEM_IMAGE)
+    {
+      continue;
+    }
+
+    Image image;
+    image.begin = ulongptr(mem.BaseAddress);
+    image.end = image.begin + mem.RegionSize;
+    image.base = ulongptr(mem.AllocationBase);
+
+    if (!m_images.empty() && m_images.back().end == image.begin && m_images.back().base == image.base)
+    {
+      m_images.back().end = image.end;
+    }
+    else
+    {
+      m_images.push_back(image);
+    }
+  }
+
+  const auto ranges = coalesce_memories(memories);
+  if (ranges.empty())
+  {
+    return true;
+  }
+
+  std::vector<MemoryRange> blocks;
+
+  for (const auto& range : ranges)
+  {
+    for (ulongptr address = range.begin; address < range.end; address += POINTER_SCAN_BLOCK_SIZE)
+    {
+      MemoryRange block;
+      block.begin = address;
+      block.end = range.end - address < POINTER_SCAN_BLOCK_SIZE ? range.end : address + POINTER_SCAN_BLOCK_SIZE;
+      blocks.push_back(block);
+    }
+  }
+
+  // the locations are kept as the 32-bit slots, they cover 32 GiB of the readable memory of a 64-bit
+  // process and all of a 32-bit one, the index of more memory would not fit in the memory anyway
+
+  const size_t n_slots = POINTER_SCAN_BLOCK_SIZE / pointer_size;
+  if (uint64(blocks.size()) * n_slots > uint64(uint32(-1)) + 1)
+  {
+    this->reset();
+    m_last_error_code = ERROR_NOT_ENOUGH_MEMORY;
+    return false;
+  }
+
+  m_pointer_size = pointer_size;
+
+  for (const auto& block : blocks)
+  {
+    m_blocks.push_back(block.begin);
+  }
+
+  // index the pointers of the blocks in parallel, a value is a pointer if it is in a readable range
+
+  const HANDLE hp = m_process.handle();
+  const ulongptr low = ranges.front().begin;
+  const ulongptr high = ranges.back().end;
+
+  std::vector<std::vector<Pointer>> results(blocks.size());
+
+  run_jobs(blocks.size(), n_threads, [&](const size_t index) -> void
+  {
+    std::vector<byte> buffer(POINTER_SCAN_BLOCK_SIZE);
+
+    const auto& block = blocks[index];
+    const size_t size = size_t(block.end - block.begin);
+
+    const bool read = read_memory(hp, LPCVOID(block.begin), buffer.data(), size, false);
+
+    auto& pointers = results[index];
+
+    for (size_t offset = 0; offset < size; offset += POINTER_SCAN_PAGE_SIZE)
+    {
+      // the pages are read one by one if the whole block could not be read
+
+      const size_t n = size - offset < POINTER_SCAN_PAGE_SIZE ? size - offset : POINTER_SCAN_PAGE_SIZE;
+
+      if (!read && !read_memory(hp, LPCVOID(block.begin + offset), buffer.data() + offset, n, false))
+      {
+        continue;
+      }
+
+      for (size_t j = offset; j + pointer_size <= offset + n; j += pointer_size)
+      {
+        ulongptr value = 0;
+        memcpy(&value, buffer.data() + j, pointer_size);
+
+        if (value < low || value >= high)
+        {
+          continue;
+        }
+
+        auto it = std::upper_bound(ranges.cbegin(), ranges.cend(), value,
+          [](const ulongptr value, const MemoryRange& range) -> bool
+        {
+          return value < range.begin;
+        });
+
+        if (it == ranges.cbegin() || value >= (--it)->end)
+        {
+          continue;
+        }
+
+        Pointer pointer = { value, uint32(index * n_slots + j / pointer_size) };
+        pointers.push_back(pointer);
+      }
+    }
+
+    std::sort(pointers.begin(), pointers.end(), [](const Pointer& l, const Pointer& r) -> bool
+    {
+      return l.value < r.value;
+    });
+  });
+
+  // concatenate the sorted blocks then merge them pairwise in parallel
+
+  size_t n_pointers = 0;
+  for (const auto& pointers : results) n_pointers += pointers.size();
+
+  m_pointers.reserve(n_pointers);
+
+  std::vector<size_t> bounds(1, 0);
+
+  for (auto& pointers : results)
+  {
+    if (!pointers.empty())
+    {
+      m_pointers.insert(m_pointers.end(), pointers.cbegin(), pointers.cend());
+      bounds.push_back(m_pointers.size());
+      std::vector<Pointer>().swap(pointers);
+    }
+  }
+
+  while (bounds.size() > 2)
+  {
+    const size_t n_merges = (bounds.size() - 1) / 2;
+
+    run_jobs(n_merges, n_threads, [&](const size_t index) -> void
+    {
+      const auto begin = m_pointers.begin();
+      std::inplace_merge(
+        begin + bounds[2 * index], begin + bounds[2 * index + 1], begin + bounds[2 * index + 2],
+        [](const Pointer& l, const Pointer& r) -> bool
+      {
+        return l.value < r.value;
+      });
+    });
+
+    std::vector<size_t> merged_bounds;
+    for (size_t i = 0; i < bounds.size(); i += 2) merged_bounds.push_back(bounds[i]);
+    if (merged_bounds.back() != bounds.back()) merged_bounds.push_back(bounds.back());
+
+    bounds.swap(merged_bounds);
+  }
+
+  return true;
+}
+
+void PointerScanner::search(
+  Context& context,
+  TPaths& paths,
+  std::vector<ulong>& offsets,
+  const ulongptr address,
+  const size_t first,
+  const size_t last) const
+{
+  for (size_t i = first; i < last && context.count.load() < context.max_count; i++)
+  {
+    const auto& pointer = m_pointers[i];
+    const ulongptr location = this->location(pointer);
+
+    offsets.push_back(ulong(address - pointer.value));
+
+    // the path ends at a static pointer, otherwise search the pointers to this pointer
+
+    const auto ptr_image = this->find_image(location);
+    if (ptr_image != nullptr)
+    {
+      if (context.count++ < context.max_count)
+      {
+        PointerPath path;
+        path.module = ptr_image->base;
+        path.offset = location - ptr_image->base;
+        path.offsets.assign(offsets.crbegin(), offsets.crend());
+        paths.push_back(std::move(path));
+      }
+    }
+    else if (offsets.size() < context.max_level)
+    {
+      const ulongptr lowest = location < context.max_offset ? 0 : location - context.max_offset;
+
+      const auto it_first = std::lower_bound(m_pointers.cbegin(), m_pointers.cend(), lowest,
+        [](const Pointer& pointer, const ulongptr value) -> bool
+      {
+        return pointer.value < value;
+      });
+
+      const auto it_last = std::upper_bound(it_first, m_pointers.cend(), location,
+        [](const ulongptr value, const Pointer& pointer) -> bool
+      {
+        return value < pointer.value;
+      });
+
+      this->search(
+        context,
+        paths,
+        offsets,
+        location,
+        size_t(it_first - m_pointers.cbegin()),
+        size_t(it_last - m_pointers.cbegin()));
+    }
+
+    offsets.pop_back();
+  }
+}
+
+bool PointerScanner::scan(
+  TPaths& paths,
+  const ulongptr address,
+  const size_t max_level,
+  const ulong max_offset,
+  const size_t max_count,
+  const size_t n_threads)
+{
+  paths.clear();
+
+  if (max_level == 0)
+  {
+    return false;
+  }
+
+  if (m_pointers.empty() && !this->snapshot(n_threads))
+  {
+    return false;
+  }
+
+  // the pointers to the address are the roots of the search, they are split to the workers
+
+  const ulongptr lowest = address < max_offset ? 0 : address - max_offset;
+
+  const auto it_first = std::lower_bound(m_pointers.cbegin(), m_pointers.cend(), lowest,
+    [](const Pointer& pointer, const ulongptr value) -> bool
+  {
+    return pointer.value < value;
+  });
+
+  const auto it_last = std::upper_bound(it_first, m_pointers.cend(), address,
+    [](const ulongptr value, const Pointer& pointer) -> bool
+  {
+    return value < pointer.value;
+  });
+
+  const size_t first = size_t(it_first - m_pointers.cbegin());
+  const size_t n_roots = size_t(it_last - it_first);
+  if (n_roots == 0)
+  {
+    return true;
+  }
+
+  Context context;
+  context.max_level = max_level;
+  context.max_offset = max_offset;
+  context.max_count = max_count;
+  context.count = 0;
+
+  // each root is a job so the deep trees do not stall a worker with many roots
+
+  std::vector<TPaths> results(n_roots);
+
+  run_jobs(n_roots, n_threads, [&](const size_t index) -> void
+  {
+    std::vector<ulong> offsets;
+    offsets.reserve(max_level);
+    this->search(context, results[index], offsets, address, first + index, first + index + 1);
+  });
+
+  for (auto& result : results)
+  {
+    for (auto& path : result)
+    {
+      paths.push_back(std::move(path));
+    }
+  }
+
+  return true;
+}
+
+} // namespace vu
@@ -0,0 +1,524 @@
+/**
+ * @file   search.cpp
+ * @author Vic P.
+ * @brief  Implementation for Substring Searching
+ */
+
+#include "search.h"
+#include "simd.h"
+
+namespace vu
+{
+
+/**
+ * The short needles are found by filtering the candidates of their first and last bytes by SIMD,
+ * the long needles are found by the Two-Way algorithm that skips the haystack by the last byte of
+ * each window, so its time is linear in the worst case and sublinear on average.
+ */
+
+static const size_t TWO_WAY_MIN_LENGTH = 32;
+
+static inline bool verify_bytes(const byte* ptr, const byte* needle, const size_t length)
+{
+  // the first and the last bytes are already matched by the filter
+
+  return length <= 2 || memcmp(ptr + 1, needle + 1, length - 2) == 0;
+}
+
+/**
+ * Scalar
+ */
+
+static size_t find_first_scalar(const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  const size_t n_starts = size - length + 1;
+  const byte last = needle[length - 1];
+
+  for (size_t i = 0; i < n_starts; i++)
+  {
+    const auto p = static_cast<const byte*>(memchr(ptr + i, needle[0], n_starts - i));
+    if (p == nullptr)
+    {
+      break;
+    }
+
+    i = size_t(p - ptr);
+
+    if (ptr[i + length - 1] == last && verify_bytes(ptr + i, needle, length))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static size_t find_last_scalar(const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  const byte first = needle[0];
+  const byte last  = needle[length - 1];
+
+  for (size_t i = size - length + 1; i-- > 0;)
+  {
+    if (ptr[i] == first && ptr[i + length - 1] == last && verify_bytes(ptr + i, needle, length))
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+#ifdef VU_SIMD_X86
+
+/**
+ * SSE2
+ */
+
+VU_TARGET_SSE2 static size_t find_first_sse2(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  const auto v1 = _mm_set1_epi8(char(needle[0]));
+  const auto v2 = _mm_set1_epi8(char(needle[length - 1]));
+
+  const size_t n_starts = size - length + 1;
+
+  size_t i = 0;
+
+  for (; i + 16 <= n_starts; i += 16)
+  {
+    const auto d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+    const auto d2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i + length - 1));
+    uint32 candidates = uint32(_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(d1, v1), _mm_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const size_t offset = i + bit_scan_forward(candidates);
+      if (verify_bytes(ptr + offset, needle, length))
+      {
+        return offset;
+      }
+
+      candidates &= candidates - 1;
+    }
+  }
+
+  const size_t offset = find_first_scalar(ptr + i, size - i, needle, length);
+  return offset == -1 ? -1 : i + offset;
+}
+
+VU_TARGET_SSE2 static size_t find_last_sse2(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  const auto v1 = _mm_set1_epi8(char(needle[0]));
+  const auto v2 = _mm_set1_epi8(char(needle[length - 1]));
+
+  size_t i = size - length + 1;
+
+  while (i >= 16)
+  {
+    i -= 16;
+
+    const auto d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+    const auto d2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i + length - 1));
+    uint32 candidates = uint32(_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(d1, v1), _mm_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const ulong bit = bit_scan_reverse(candidates);
+      if (verify_bytes(ptr + i + bit, needle, length))
+      {
+        return i + bit;
+      }
+
+      candidates &= ~(1U << bit);
+    }
+  }
+
+  // the remaining starts are [0, i)
+
+  return find_last_scalar(ptr, i + length - 1, needle, length);
+}
+
+/**
+ * AVX2
+ */
+
+VU_TARGET_AVX2 static size_t find_first_avx2(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  const auto v1 = _mm256_set1_epi8(char(needle[0]));
+  const auto v2 = _mm256_set1_epi8(char(needle[length - 1]));
+
+  const size_t n_starts = size - length + 1;
+
+  size_t i = 0;
+
+  for (; i + 32 <= n_starts; i += 32)
+  {
+    const auto d1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i));
+    const auto d2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i + length - 1));
+    uint32 candidates = uint32(_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(d1, v1), _mm256_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const size_t offset = i + bit_scan_forward(candidates);
+      if (verify_bytes(ptr + offset, needle, length))
+      {
+        return offset;
+      }
+
+      candidates &= candidates - 1;
+    }
+  }
+
+  // The remaining starts are fewer than a vector so finish them by the narrower kernel
+
+  const size_t offset = find_first_sse2(ptr + i, size - i, needle, length);
+  return offset == -1 ? -1 : i + offset;
+}
+
+VU_TARGET_AVX2 static size_t find_last_avx2(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (size < length)
+  {
+    return -1;
+  }
+
+  const auto v1 = _mm256_set1_epi8(char(needle[0]));
+  const auto v2 = _mm256_set1_epi8(char(needle[length - 1]));
+
+  size_t i = size - length + 1;
+
+  while (i >= 32)
+  {
+    i -= 32;
+
+    const auto d1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i));
+    const auto d2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i + length - 1));
+    uint32 candidates = uint32(_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(d1, v1), _mm256_cmpeq_epi8(d2, v2))));
+
+    while (candidates != 0)
+    {
+      const ulong bit = bit_scan_reverse(candidates);
+      if (verify_bytes(ptr + i + bit, needle, length))
+      {
+        return i + bit;
+      }
+
+      candidates &= ~(1U << bit);
+    }
+  }
+
+  return find_last_sse2(ptr, i + length - 1, needle, length);
+}
+
+#endif // VU_SIMD_X86
+
+/**
+ * Two-Way
+ * The needle is split at its critical position, the right part is compared from left to right then
+ * the left part from right to left. The window is also skipped by the last byte of it, like Horspool.
+ */
+
+struct TwoWay
+{
+  const byte* needle;
+  size_t length;
+  size_t split;   // The last index of the left part, -1 if the left part is empty
+  size_t period;  // The shift after the right part is matched
+  size_t memory;  // The number of bytes known to be matched after a shift by the period
+  size_t shifts[256];
+
+  TwoWay(const byte* ptr, const size_t size) : needle(ptr), length(size)
+  {
+    memset(shifts, 0, sizeof(shifts));
+
+    for (size_t i = 0; i < length; i++)
+    {
+      shifts[needle[i]] = i + 1; // zero if the byte is not in the needle
+    }
+
+    // the maximal suffixes for both orders of the bytes, the longer one is the critical factorization
+
+    size_t p0 = 0;
+    const size_t ms0 = maximal_suffix(false, p0);
+
+    size_t p1 = 0;
+    const size_t ms1 = maximal_suffix(true, p1);
+
+    split  = ms1 + 1 > ms0 + 1 ? ms1 : ms0;
+    period = ms1 + 1 > ms0 + 1 ? p1 : p0;
+
+    // a periodic needle remembers the matched prefix after a shift by the period
+
+    if (memcmp(needle, needle + period, split + 1) == 0)
+    {
+      memory = length - period;
+    }
+    else
+    {
+      memory = 0;
+      period = (split > length - split - 1 ? split : length - split - 1) + 1;
+    }
+  }
+
+  size_t maximal_suffix(const bool reversed, size_t& p) const
+  {
+    size_t ip = -1, jp = 0, k = 1;
+
+    p = 1;
+
+    while (jp + k < length)
+    {
+      const byte a = needle[ip + k];
+      const byte b = needle[jp + k];
+
+      if (a == b)
+      {
+        if (k == p)
+        {
+          jp += p;
+          k = 1;
+        }
+        else
+        {
+          k++;
+        }
+      }
+      else if (reversed ? a < b : a > b)
+      {
+        jp += k;
+        k = 1;
+        p = jp - ip;
+      }
+      else
+      {
+        ip = jp++;
+        k = p = 1;
+      }
+    }
+
+    return ip;
+  }
+
+  /**
+   * Find the next occurrence from the window `h`, the state is updated to continue after it.
+   * @param mem The number of bytes known to be matched at the window `h`, zero at first.
+   */
+  size_t next(const byte* ptr, const size_t size, size_t& h, size_t& mem) const
+  {
+    while (h <= size && size - h >= length)
+    {
+      const size_t shift = shifts[ptr[h + length - 1]];
+      if (shift == 0)
+      {
+        h += length;
+        mem = 0;
+        continue;
+      }
+
+      size_t k = length - shift;
+      if (k != 0)
+      {
+        h += k < mem ? mem : k;
+        mem = 0;
+        continue;
+      }
+
+      // the right part
+
+      for (k = split + 1 > mem ? split + 1 : mem; k < length && needle[k] == ptr[h + k]; k++);
+
+      if (k < length)
+      {
+        h += k - split;
+        mem = 0;
+        continue;
+      }
+
+      // the left part
+
+      for (k = split + 1; k > mem && needle[k - 1] == ptr[h + k - 1]; k--);
+
+      const bool matched = k <= mem;
+      const size_t offset = h;
+
+      h += period;
+      mem = memory;
+
+      if (matched)
+      {
+        return offset;
+      }
+    }
+
+    return -1;
+  }
+};
+
+/**
+ * Dispatcher
+ */
+
+typedef size_t (*fn_find_bytes_t)(const byte* ptr, const size_t size, const byte* needle, const size_t length);
+
+static fn_find_bytes_t select_find_first_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return find_first_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return find_first_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return find_first_scalar;
+}
+
+static fn_find_bytes_t select_find_last_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return find_last_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return find_last_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return find_last_scalar;
+}
+
+size_t find_bytes_first(const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (ptr == nullptr || needle == nullptr || length == 0 || size < length)
+  {
+    return -1;
+  }
+
+  if (length == 1)
+  {
+    const auto p = static_cast<const byte*>(memchr(ptr, needle[0], size));
+    return p == nullptr ? -1 : size_t(p - ptr);
+  }
+
+  if (length >= TWO_WAY_MIN_LENGTH)
+  {
+    const TwoWay two_way(needle, length);
+    size_t h = 0, mem = 0;
+    return two_way.next(ptr, size, h, mem);
+  }
+
+  static const fn_find_bytes_t fn = select_find_first_kernel();
+
+  return fn(ptr, size, needle, length);
+}
+
+size_t find_bytes_last(const byte* ptr, const size_t size, const byte* needle, const size_t length)
+{
+  if (ptr == nullptr || needle == nullptr || length == 0 || size < length)
+  {
+    return -1;
+  }
+
+  // the backward searching filters the candidates by SIMD for all lengths of the needles
+
+  static const fn_find_bytes_t fn = select_find_last_kernel();
+
+  return fn(ptr, size, needle, length);
+}
+
+size_t find_bytes_all(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length, std::vector<size_t>* offsets)
+{
+  size_t count = 0;
+
+  if (ptr == nullptr || needle == nullptr || length == 0 || size < length)
+  {
+    return count;
+  }
+
+  if (length >= TWO_WAY_MIN_LENGTH)
+  {
+    // continue from the state of the last occurrence instead of starting over after it
+
+    const TwoWay two_way(needle, length);
+    size_t h = 0, mem = 0;
+
+    for (size_t offset = two_way.next(ptr, size, h, mem); offset != -1; offset = two_way.next(ptr, size, h, mem))
+    {
+      if (offsets != nullptr)
+      {
+        offsets->push_back(offset);
+      }
+
+      count++;
+    }
+
+    return count;
+  }
+
+  for (size_t i = 0; i <= size - length;)
+  {
+    const size_t offset = find_bytes_first(ptr + i, size - i, needle, length);
+    if (offset == -1)
+    {
+      break;
+    }
+
+    if (offsets != nullptr)
+    {
+      offsets->push_back(i + offset);
+    }
+
+    count++;
+
+    i += offset + 1;
+  }
+
+  return count;
+}
+
+} // namespace vu
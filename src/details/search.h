@@ -0,0 +1,34 @@
+/**
+ * @file   search.h
+ * @author Vic P.
+ * @brief  Header for Substring Searching
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+/**
+ * Find the first occurrence of a needle in a memory region.
+ * @return The offset of the first occurrence or -1 if not found.
+ */
+size_t find_bytes_first(const byte* ptr, const size_t size, const byte* needle, const size_t length);
+
+/**
+ * Find the last occurrence of a needle in a memory region.
+ * @return The offset of the last occurrence or -1 if not found.
+ */
+size_t find_bytes_last(const byte* ptr, const size_t size, const byte* needle, const size_t length);
+
+/**
+ * Find all occurrences of a needle in a memory region, the occurrences can be overlapped.
+ * @param offsets The offsets of the occurrences, could be null if only counting them.
+ * @return The number of the occurrences.
+ */
+size_t find_bytes_all(
+  const byte* ptr, const size_t size, const byte* needle, const size_t length, std::vector<size_t>* offsets);
+
+} // namespace vu
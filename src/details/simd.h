@@ -0,0 +1,174 @@
+/**
+ * @file   simd.h
+ * @author Vic P.
+ * @brief  Header for SIMD
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+/**
+ * SIMD Availability
+ * The kernels are compiled in regardless of the compiler options and are only selected at runtime
+ * if the running processor supports them, so the library still works on the older processors.
+ */
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define VU_SIMD_X86
+#endif
+
+#ifdef VU_SIMD_X86
+
+#include <emmintrin.h> // SSE2
+#include <tmmintrin.h> // SSSE3
+#include <immintrin.h> // AVX2
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else  // MinGW
+#include <cpuid.h>
+#endif // _MSC_VER
+
+#endif // VU_SIMD_X86
+
+/**
+ * Function Target Attributes
+ * MSVC allows to use any intrinsic anywhere, but GCC requires the functions that use them to be marked.
+ */
+
+#if defined(VU_SIMD_X86) && defined(__GNUC__)
+#define VU_TARGET_SSE2  __attribute__((target("sse2")))
+#define VU_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define VU_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#define VU_TARGET_SSE2
+#define VU_TARGET_SSSE3
+#define VU_TARGET_AVX2
+#endif
+
+namespace vu
+{
+
+/**
+ * Count trailing zero bits of a non-zero mask.
+ */
+
+inline ulong bit_scan_forward(uint32 mask)
+{
+  #if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, mask);
+  return index;
+  #else  // MinGW
+  return __builtin_ctz(mask);
+  #endif // _MSC_VER
+}
+
+inline ulong bit_scan_forward(uint64 mask)
+{
+  const uint32 low = uint32(mask);
+  return low != 0 ? bit_scan_forward(low) : 32 + bit_scan_forward(uint32(mask >> 32));
+}
+
+/**
+ * Index of the highest set bit of a non-zero mask.
+ */
+
+inline ulong bit_scan_reverse(uint32 mask)
+{
+  #if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanReverse(&index, mask);
+  return index;
+  #else  // MinGW
+  return 31 - __builtin_clz(mask);
+  #endif // _MSC_VER
+}
+
+/**
+ * Count the set bits of a mask (SWAR, the POPCNT instruction is not guaranteed by SSE2).
+ */
+
+inline ulong pop_count(uint64 mask)
+{
+  mask = mask - ((mask >> 1) & 0x5555555555555555ULL);
+  mask = (mask & 0x3333333333333333ULL) + ((mask >> 2) & 0x3333333333333333ULL);
+  mask = (mask + (mask >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return ulong((mask * 0x0101010101010101ULL) >> 56);
+}
+
+/**
+ * CPU Features
+ */
+
+struct CPUFeatures
+{
+  bool sse2;
+  bool ssse3;
+  bool sse42;
+  bool avx2;
+
+  CPUFeatures() : sse2(false), ssse3(false), sse42(false), avx2(false)
+  {
+    #ifdef VU_SIMD_X86
+
+    int regs[4] = { 0 }; // EAX, EBX, ECX, EDX
+
+    const auto cpuid = [](int regs[4], int leaf, int sub_leaf) -> void
+    {
+      #if defined(_MSC_VER)
+      __cpuidex(regs, leaf, sub_leaf);
+      #else  // MinGW
+      __cpuid_count(leaf, sub_leaf, regs[0], regs[1], regs[2], regs[3]);
+      #endif // _MSC_VER
+    };
+
+    cpuid(regs, 0, 0);
+    const int n_leaves = regs[0];
+    if (n_leaves < 1)
+    {
+      return;
+    }
+
+    cpuid(regs, 1, 0);
+    sse2  = (regs[3] & (1 << 26)) != 0;
+    ssse3 = (regs[2] & (1 << 9))  != 0;
+    sse42 = (regs[2] & (1 << 20)) != 0;
+
+    // AVX2 also requires the OS to save the YMM registers on context switching (OSXSAVE + XCR0)
+
+    const bool os_xsave = (regs[2] & (1 << 27)) != 0;
+    const bool cpu_avx  = (regs[2] & (1 << 28)) != 0;
+    if (!os_xsave || !cpu_avx || n_leaves < 7)
+    {
+      return;
+    }
+
+    #if defined(_MSC_VER)
+    const uint64 xcr0 = _xgetbv(0);
+    #else  // MinGW
+    uint32 eax = 0, edx = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    const uint64 xcr0 = (uint64(edx) << 32) | eax;
+    #endif // _MSC_VER
+
+    if ((xcr0 & 0x06) != 0x06) // XMM & YMM state
+    {
+      return;
+    }
+
+    cpuid(regs, 7, 0);
+    avx2 = (regs[1] & (1 << 5)) != 0;
+
+    #endif // VU_SIMD_X86
+  }
+
+  static const CPUFeatures& instance()
+  {
+    static const CPUFeatures features;
+    return features;
+  }
+};
+
+} // namespace vu
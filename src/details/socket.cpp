@@ -321,6 +321,80 @@ IResult vuapi Socket::send(const Buffer& buffer, const flags_t flags)
   return this->send((const char*)buffer.get_ptr(), int(buffer.get_size()), flags);
 }
 
+IResult vuapi Socket::send(const BufferView& view, const flags_t flags)
+{
+  return this->send((const char*)view.get_ptr(), int(view.get_size()), flags);
+}
+
+IResult vuapi Socket::send(const BufferChain& chain, const flags_t flags)
+{
+  if (!this->available())
+  {
+    return SOCKET_ERROR;
+  }
+
+  // gather the segments to a single vectored send, the large segments are split to the chunks of a buffer
+
+  const size_t MAX_WSABUF_SIZE = 0x7FFFFFFF;
+
+  std::vector<WSABUF> buffers;
+  buffers.reserve(chain.count());
+
+  for (size_t i = 0; i < chain.count(); i++)
+  {
+    const auto view = chain.at(i);
+
+    for (size_t offset = 0; offset < view.get_size(); offset += MAX_WSABUF_SIZE)
+    {
+      const size_t n = view.get_size() - offset < MAX_WSABUF_SIZE ? view.get_size() - offset : MAX_WSABUF_SIZE;
+
+      WSABUF buffer;
+      buffer.buf = (CHAR*)(view.get_ptr_bytes() + offset);
+      buffer.len = ULONG(n);
+      buffers.push_back(buffer);
+    }
+  }
+
+  IResult sent_bytes = 0;
+
+  for (size_t index = 0; index < buffers.size();)
+  {
+    DWORD z = 0;
+
+    if (WSASend(
+      m_socket, &buffers[index], DWORD(buffers.size() - index), &z, DWORD(flags), nullptr, nullptr) == SOCKET_ERROR)
+    {
+      m_last_error_code = GetLastError();
+      return SOCKET_ERROR;
+    }
+
+    // nothing was sent so the connection is closed, the bytes sent so far are returned
+
+    if (z == 0)
+    {
+      break;
+    }
+
+    sent_bytes += IResult(z);
+
+    // skip the sent buffers and advance the partially sent one
+
+    for (; z != 0 && index < buffers.size(); index++)
+    {
+      if (z < buffers[index].len)
+      {
+        buffers[index].buf += z;
+        buffers[index].len -= z;
+        break;
+      }
+
+      z -= buffers[index].len;
+    }
+  }
+
+  return sent_bytes;
+}
+
 IResult vuapi Socket::recv(char* ptr_data, int size, const flags_t flags)
 {
   if (!this->available())
@@ -375,10 +449,11 @@ IResult vuapi Socket::recv(Buffer& buffer, const flags_t flags)
 IResult vuapi Socket::recv_all(Buffer& buffer, const flags_t flags)
 {
   Buffer block;
+  block.set_pool(buffer.get_pool());
 
   do
   {
-    block.resize(VU_DEFAULT_SEND_RECV_BLOCK_SIZE);
+    block.resize(VU_DEFAULT_SEND_RECV_BLOCK_SIZE, false); // overwritten by the receiving
     IResult z = this->recv(block, flags);
     if (z <= 0) // error or completed
     {
@@ -476,10 +551,11 @@ IResult vuapi Socket::recv_from(char* ptr_data, int size, const Handle& socket)
 IResult vuapi Socket::recv_all_from(Buffer& buffer, const Handle& socket)
 {
   Buffer block;
+  block.set_pool(buffer.get_pool());
 
   do
   {
-    block.resize(VU_DEFAULT_SEND_RECV_BLOCK_SIZE);
+    block.resize(VU_DEFAULT_SEND_RECV_BLOCK_SIZE, false); // overwritten by the receiving
     IResult z = this->recv_from(block, socket);
     if (z <= 0) // error or completed
     {
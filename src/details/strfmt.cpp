@@ -6,9 +6,9 @@
 
 #include "strfmt.h"
 #include "lazy.h"
+#include "hex.h"
 
 #include <math.h>
-#include <iomanip>
 
 namespace vu
 {
@@ -81,11 +81,44 @@ int vuapi get_format_length_W(const std::wstring format, ...)
   return N;
 }
 
+/**
+ * The text is formatted into a stack buffer first, it is measured and formatted again on the heap only
+ * when the stack buffer is too small.
+ */
+
+#ifndef va_copy
+#define va_copy(d, s) ((d) = (s))
+#endif // va_copy
+
+static const int FORMAT_STACK_SIZE = 512;
+
 std::string vuapi format_vl_A(const std::string format, va_list args)
 {
   std::string s;
   s.clear();
 
+  if (Initialize_DLL_MISC() != VU_OK)
+  {
+    return s;
+  }
+
+  char buffer[FORMAT_STACK_SIZE];
+
+  va_list list;
+  va_copy(list, args);
+  #ifdef _MSC_VER
+  const int n = vsnprintf(buffer, FORMAT_STACK_SIZE, format.c_str(), list);
+  #else
+  const int n = pfn_vsnprintf(buffer, FORMAT_STACK_SIZE, format.c_str(), list);
+  #endif
+  va_end(list);
+
+  if (n >= 0 && n < FORMAT_STACK_SIZE)
+  {
+    s.assign(buffer, n);
+    return s;
+  }
+
   auto N = get_format_length_vl_A(format, args);
   if (N <= 0)
   {
@@ -116,6 +149,24 @@ std::wstring vuapi format_vl_W(const std::wstring format, va_list args)
   std::wstring s;
   s.clear();
 
+  if (Initialize_DLL_MISC() != VU_OK)
+  {
+    return s;
+  }
+
+  wchar buffer[FORMAT_STACK_SIZE];
+
+  va_list list;
+  va_copy(list, args);
+  const int n = _vsnwprintf(buffer, FORMAT_STACK_SIZE, format.c_str(), list);
+  va_end(list);
+
+  if (n >= 0 && n < FORMAT_STACK_SIZE)
+  {
+    s.assign(buffer, n);
+    return s;
+  }
+
   auto N = get_format_length_vl_W(format, args);
   if (N <= 0)
   {
@@ -130,11 +181,7 @@ std::wstring vuapi format_vl_W(const std::wstring format, va_list args)
 
   ZeroMemory(p.get(), 2*N);
 
-  #ifdef _MSC_VER
-  vswprintf(p.get(), format.c_str(), args);
-  #else
-  pfn_vswprintf(p.get(), N, format.c_str(), args);
-  #endif
+  _vsnwprintf(p.get(), N, format.c_str(), args);
 
   s.assign(p.get());
 
@@ -317,66 +364,6 @@ std::wstring vuapi get_last_error_W(ulong code)
   // return s;
 }
 
-std::string vuapi get_format_string_for_number(std::string type_id)
-{
-  /* MinGW
-    i -> int
-    l -> long
-    x -> long long
-    j -> unsigned
-    m -> unsigned long
-    y -> unsigned long long
-    f -> float
-    d -> double
-    e -> long double
-  */
-
-  std::string fs = "";
-
-  if (type_id == "i")
-  {
-    fs = "%d";
-  }
-  else if (type_id == "l")
-  {
-    fs = "%ld";
-  }
-  else if (type_id == "x")
-  {
-    fs = "lld";
-  }
-  else if (type_id == "j")
-  {
-    fs = "%u";
-  }
-  else if (type_id == "m")
-  {
-    fs = "%lu";
-  }
-  else if (type_id == "y")
-  {
-    fs = "%llu";
-  }
-  else if (type_id == "f")
-  {
-    fs = "%f";
-  }
-  else if (type_id == "d")
-  {
-    fs = "%e";
-  }
-  else if (type_id == "e")
-  {
-    fs = "%Le";
-  }
-  else
-  {
-    fs = "";
-  }
-
-  return fs;
-}
-
 std::string vuapi date_time_to_string_A(const time_t t)
 {
   std::string s = format_date_time_A(t, "%H:%M:%S %d/%m/%Y");
@@ -444,46 +431,83 @@ std::wstring vuapi format_date_time_W(const time_t t, const std::wstring format)
 
 void vuapi hex_dump(const void* data, int size)
 {
-  const int DEFAULT_DUMP_COLUMN = 16;
+  if (size <= 0)
+  {
+    return;
+  }
+
+  std::string result;
+  hex_dump(data, size_t(size), result);
+
+  fputs(result.c_str(), stdout);
+}
+
+void vuapi hex_dump(const void* data, const size_t size, std::string& result)
+{
+  const size_t DEFAULT_DUMP_COLUMN = 16;
+  const size_t DEFAULT_LINE_LENGTH = 80;
+
+  static const char DIGITS[] = "0123456789abcdef";
 
-  int i = 0;
-  uchar buffer[DEFAULT_DUMP_COLUMN + 1], *ptr_data = (uchar*)data;
+  result.clear();
 
-  for (int i = 0; i < size; i++)
+  if (data == nullptr || size == 0)
   {
-    if (i % DEFAULT_DUMP_COLUMN == 0)
+    return;
+  }
+
+  result.reserve((size + DEFAULT_DUMP_COLUMN - 1) / DEFAULT_DUMP_COLUMN * DEFAULT_LINE_LENGTH);
+
+  const byte* ptr_data = static_cast<const byte*>(data);
+
+  // each line is formatted to a local buffer then appended, eg.
+  // "  0010  48 65 6c 6c 6f 20 57 6f  72 6c 64 0a 00 00 00 00  Hello World....."
+
+  char line[2 * DEFAULT_LINE_LENGTH];
+  char hex[2 * DEFAULT_DUMP_COLUMN];
+
+  for (size_t offset = 0; offset < size; offset += DEFAULT_DUMP_COLUMN)
+  {
+    const size_t n = size - offset < DEFAULT_DUMP_COLUMN ? size - offset : DEFAULT_DUMP_COLUMN;
+
+    encode_hex(ptr_data + offset, n, hex, false, 0);
+
+    char* p = line;
+
+    *p++ = ' ';
+    *p++ = ' ';
+
+    size_t n_digits = 4;
+    while (n_digits < 2 * sizeof(size_t) && (offset >> (4 * n_digits)) != 0) n_digits++;
+    for (size_t i = n_digits; i-- > 0;) *p++ = DIGITS[(offset >> (4 * i)) & 0x0F];
+
+    *p++ = ' ';
+
+    for (size_t i = 0; i < DEFAULT_DUMP_COLUMN; i++)
     {
-      if (i != 0)
+      if (i == DEFAULT_DUMP_COLUMN / 2)
       {
-        printf("  %s\n", buffer);
+        *p++ = ' ';
       }
 
-      printf("  %04x ", i);
+      *p++ = ' ';
+      *p++ = i < n ? hex[2 * i] : ' ';
+      *p++ = i < n ? hex[2 * i + 1] : ' ';
     }
 
-    if (i % DEFAULT_DUMP_COLUMN == 8) printf(" ");
-
-    printf(" %02x", ptr_data[i]);
+    *p++ = ' ';
+    *p++ = ' ';
 
-    if (ptr_data[i] < 0x20 || ptr_data[i] > 0x7E)
+    for (size_t i = 0; i < n; i++)
     {
-      buffer[i % DEFAULT_DUMP_COLUMN] = '.';
-    }
-    else
-    {
-      buffer[i % DEFAULT_DUMP_COLUMN] = ptr_data[i];
+      const byte c = ptr_data[offset + i];
+      *p++ = c < 0x20 || c > 0x7E ? '.' : char(c);
     }
 
-    buffer[(i % DEFAULT_DUMP_COLUMN) + 1] = '\0';
-  }
+    *p++ = '\n';
 
-  while (i % DEFAULT_DUMP_COLUMN != 0)
-  {
-    printf("   ");
-    i++;
+    result.append(line, p - line);
   }
-
-  printf("  %s\n", buffer);
 }
 
 std::string vuapi format_bytes_A(long long bytes, data_unit_type dut, int digits)
@@ -533,124 +557,108 @@ std::wstring vuapi format_bytes_W(long long bytes, data_unit_type dut, int digit
   return to_string_W(format_bytes_A(bytes, dut, digits));
 }
 
-std::string vuapi to_hex_string_A(const byte* ptr, const size_t size)
+std::string vuapi to_hex_string_A(
+  const byte* ptr, const size_t size, const bool upper, const char separator)
 {
-  std::stringstream ss;
-
-  for (size_t i = 0; i < size; i++)
+  if (ptr == nullptr || size == 0)
   {
-    ss << std::hex << std::setfill('0') << std::setw(2) << int(ptr[i]);
+    return std::string();
   }
 
-  return ss.str();
+  std::string result(hex_text_length(size, separator != 0), '\0');
+  encode_hex(ptr, size, &result[0], upper, separator);
+
+  return result;
 }
 
-std::wstring vuapi to_hex_string_W(const byte* ptr, const size_t size)
+std::wstring vuapi to_hex_string_W(
+  const byte* ptr, const size_t size, const bool upper, const wchar separator)
 {
-  auto s = to_hex_string_A(ptr, size);
-  return to_string_W(s);
+  if (ptr == nullptr || size == 0)
+  {
+    return std::wstring();
+  }
+
+  std::wstring result(hex_text_length(size, separator != 0), L'\0');
+  encode_hex(ptr, size, &result[0], upper, separator);
+
+  return result;
 }
 
-bool vuapi to_hex_bytes_A(const std::string& text, std::vector<byte>& bytes)
+size_t vuapi to_hex_string_A(
+  const byte* ptr, const size_t size, char* text, const size_t length, const bool upper, const char separator)
 {
-  bytes.clear();
+  const size_t needed = hex_text_length(size, separator != 0);
 
-  auto s = trim_string_A(text);
-  s = replace_string_A(s, " ", "");
+  if (ptr != nullptr && text != nullptr && length >= needed)
+  {
+    encode_hex(ptr, size, text, upper, separator);
+  }
+
+  return needed;
+}
 
-  const size_t byte_width = 2;
+size_t vuapi to_hex_string_W(
+  const byte* ptr, const size_t size, wchar* text, const size_t length, const bool upper, const wchar separator)
+{
+  const size_t needed = hex_text_length(size, separator != 0);
 
-  if (s.size() % byte_width != 0)
+  if (ptr != nullptr && text != nullptr && length >= needed)
   {
-    throw "invalid hex string";
+    encode_hex(ptr, size, text, upper, separator);
   }
 
-  bytes.reserve(s.size() / byte_width);
+  return needed;
+}
+
+template <typename std_string_t>
+static bool to_hex_bytes_T(const std_string_t& text, std::vector<byte>& bytes)
+{
+  // every byte takes two digits at least, so the bytes never grow while decoding
+
+  bytes.resize(text.size() / 2);
+
+  size_t size = bytes.size();
 
-  for (size_t i = 0; i < s.size(); i += byte_width)
+  if (!decode_hex(text.data(), text.size(), bytes.data(), size))
   {
-    const std::string e = s.substr(i, byte_width);
-    if (!isxdigit(e[0]) || !isxdigit(e[1]))
-    {
-      throw "invalid hex string";
-    }
-    
-    bytes.push_back((byte)strtoul(e.c_str(), nullptr, 16));
+    bytes.clear();
+    throw "invalid hex string";
   }
 
+  bytes.resize(size);
+
   return true;
 }
 
-bool vuapi to_hex_bytes_W(const std::wstring& text, std::vector<byte>& bytes)
+bool vuapi to_hex_bytes_A(const std::string& text, std::vector<byte>& bytes)
 {
-  const auto s = to_string_A(text);
-  return to_hex_bytes_A(s, bytes);
+  return to_hex_bytes_T(text, bytes);
 }
 
-void vuapi url_encode_A(const std::string& text, std::string& result)
+bool vuapi to_hex_bytes_W(const std::wstring& text, std::vector<byte>& bytes)
 {
-  auto s = to_string_W(text);
-  std::wstring res = L"";
-  url_encode_W(s, res);
-  result = to_string_A(res);
+  return to_hex_bytes_T(text, bytes);
 }
 
-void vuapi url_encode_W(const std::wstring& text, std::wstring& result)
+bool vuapi to_hex_bytes_A(const char* text, const size_t length, byte* bytes, size_t& size)
 {
-  result.clear();
-
-  for (const auto& c : text)
+  if (text == nullptr && length != 0)
   {
-    // uncomment this if you want to encode spaces with +
-    // if (c==' ')
-    // {
-    //   result += '+';
-    // }
-    // else
-    if (iswalnum(c) || c == L'-' || c == L'_' || c == L'.' || c == L'~')
-    {
-      result += c;
-    }
-    else
-    {
-      wchar_t s[10] = {0};
-      #ifdef __MINGW32__
-      _itow_s(c, s, ARRAYSIZE(s), 16);
-      #else // _MSC_VER
-      _itow_s(c, s, 16);
-      #endif
-      result += c < 16 ? L"%0" : L"%";
-      result += s;
-    }
+    return false;
   }
-}
 
-void vuapi url_decode_A(const std::string& text, std::string& result)
-{
-  auto s = to_string_W(text);
-  std::wstring res = L"";
-  url_decode_W(s, res);
-  result = to_string_A(res);
+  return decode_hex(text, length, bytes, size);
 }
 
-void vuapi url_decode_W(const std::wstring& text, std::wstring& result)
+bool vuapi to_hex_bytes_W(const wchar* text, const size_t length, byte* bytes, size_t& size)
 {
-  result.clear();
-
-  for (size_t i = 0; i < text.length(); i++)
+  if (text == nullptr && length != 0)
   {
-    if (text[i] != L'%')
-    {
-      result += text[i] == L'+' ? L' ' : text[i];
-    }
-    else
-    {
-      int v = 0;
-      swscanf_s(text.substr(i + 1, 2).c_str(), L"%x", &v);
-      result += wchar_t(v);
-      i += 2;
-    }
+    return false;
   }
+
+  return decode_hex(text, length, bytes, size);
 }
 
 /**
@@ -13,64 +13,62 @@ namespace vu
 
 int vuapi get_format_length_A(const std::string format, ...);
 int vuapi get_format_length_W(const std::wstring format, ...);
-std::string vuapi get_format_string_for_number(std::string type_id);
 
-template<typename T>
-std::string vuapi number_to_string_A(T v)
-{
-  #if defined(__MINGW32__)
-  std::string s = "";
-  std::string tid = std::string(typeid(v).name());
-  std::string fs = get_format_string_for_number(tid);
-
-  int z = get_format_length_A(fs, v);
-  if (z <= 0)
-  {
-    return s;
-  }
-
-  std::unique_ptr<char[]> p(new char [z]);
-  memset(p.get(), 0, z*sizeof(char));
-  sprintf(p.get(), fs.c_str(), v);
-  s.assign(p.get());
+/**
+ * The integers are written by the digit pairs into a stack buffer, the floating points are written as
+ * std::to_string does ("%f").
+ */
 
-  return s;
-  #else // defined(_MSC_VER) - defined(__BCPLUSPLUS__)
-  return std::to_string(v);
-  #endif
+template <typename T>
+T* write_number(T* end, const long long v)
+{
+  return fmt_write_signed(end, int64(v));
 }
 
-template<typename T>
-std::wstring vuapi number_to_string_W(T v)
+template <typename T>
+T* write_number(T* end, const unsigned long long v)
 {
-  #if defined(__MINGW32__)
-  std::wstring s = L"";
-  std::string tid = std::string(typeid(v).name());
+  return fmt_write_unsigned(end, uint64(v));
+}
 
-  std::string fs = get_format_string_for_number(tid);
+template <typename T>
+T* write_number(T* end, const long double v)
+{
+  char text[VU_FMT_NUMBER_SIZE + 256]; // DBL_MAX has 309 digits before the point
+  const int n = _snprintf(text, sizeof(text) - 1, "%f", double(v));
 
-  if (fs == "%Le")   // Does not support now
+  T* begin = end - (n > 0 ? n : 0);
+  for (int i = 0; i < n; i++)
   {
-    return s;
+    begin[i] = T(text[i]);
   }
 
-  std::wstring wfs = to_string_W(fs);
+  return begin;
+}
 
-  int z = get_format_length_W(wfs, v);
-  if (z <= 0)
-  {
-    return s;
-  }
+template <typename N, typename T>
+std::basic_string<T> number_to_basic_string(const N v)
+{
+  typedef typename std::conditional<std::is_floating_point<N>::value, long double,
+    typename std::conditional<std::is_signed<N>::value, long long, unsigned long long>::type>::type TNumber;
+
+  T buffer[VU_FMT_NUMBER_SIZE + 256];
+  T* end = buffer + sizeof(buffer) / sizeof(T);
+  T* begin = write_number(end, TNumber(v));
+
+  return std::basic_string<T>(begin, end);
+}
 
-  std::unique_ptr<wchar[]> p(new wchar [z]);
-  memset(p.get(), 0, z*sizeof(wchar));
-  _snwprintf(p.get(), z*sizeof(wchar), wfs.c_str(), v);
-  s.assign(p.get());
+template<typename T>
+std::string vuapi number_to_string_A(T v)
+{
+  return number_to_basic_string<T, char>(v);
+}
 
-  return s;
-  #else // defined(_MSC_VER) - defined(__BCPLUSPLUS__)
-  return std::to_wstring(v);
-  #endif
+template<typename T>
+std::wstring vuapi number_to_string_W(T v)
+{
+  return number_to_basic_string<T, wchar>(v);
 }
 
 } // namespace vu
\ No newline at end of file
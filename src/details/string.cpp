@@ -5,8 +5,10 @@
  */
 
 #include "Vutils.h"
+#include "search.h"
+#include "casefold.h"
+#include "utf.h"
 
-#include <csignal>
 #include <algorithm>
 
 namespace vu
@@ -20,88 +22,6 @@ namespace vu
 #pragma warning(disable: 26812)
 #endif // _MSC_VER
 
-#ifndef CHAR_BIT
-#define CHAR_BIT      8    // number of bits in a char
-#define SCHAR_MIN   (-128) // minimum signed char value
-#define SCHAR_MAX     127  // maximum signed char value
-#define UCHAR_MAX     255  // maximum unsigned char value
-#endif
-
-encoding_type vuapi determine_encoding_type(const void* data, const size_t size)
-{
-  if (data == nullptr || size == 0) return encoding_type::ET_UNKNOWN;
-
-  auto p = (uchar*)data;
-
-  if (size == 1)
-  {
-    /* UTF-8 */
-    if (p[0] >= SCHAR_MIN && p[0] <= SCHAR_MAX) return encoding_type::ET_UTF8_BOM;
-  }
-
-  signal(SIGSEGV, [](int signal)
-  {
-    throw signal;
-  });
-
-  try
-  {
-    /* UTF-8 BOM */
-    if (p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
-    {
-      return encoding_type::ET_UTF8_BOM;
-    }
-
-    /* UTF-32 LE BOM */
-    if (p[0] == 0xFF && p[1] == 0xFE && p[2] == 0x00 && p[3] == 0x00)
-    {
-      return encoding_type::ET_UTF32_LE_BOM;
-    }
-
-    /* UTF-32 BE BOM */
-    if (p[0] == 0x00 && p[1] == 0x00 && p[2] == 0xFE && p[3] == 0xFF)
-    {
-      return encoding_type::ET_UTF32_BE_BOM;
-    }
-
-    /* UTF-16 LE BOM */
-    if (p[0] == 0xFF && p[1] == 0xFE)
-    {
-      return encoding_type::ET_UTF16_LE_BOM;
-    }
-
-    /* UTF-16 BE BOM */
-    if (p[0] == 0xFE && p[1] == 0xFF)
-    {
-      return encoding_type::ET_UTF16_BE_BOM;
-    }
-
-    /* UTF-16 LE */
-    if ((p[0] >= SCHAR_MIN && p[0] <= SCHAR_MAX) && p[1] == 0x00)
-    {
-      return encoding_type::ET_UTF16_LE;
-    }
-
-    /* UTF-16 BE */
-    if ((p[1] >= SCHAR_MIN && p[1] <= SCHAR_MAX) && p[0] == 0x00)
-    {
-      return encoding_type::ET_UTF16_BE;
-    }
-
-    /* UTF-8 */
-    if ((p[0] >= SCHAR_MIN && p[0] <= SCHAR_MAX) && (p[1] >= SCHAR_MIN && p[1] <= SCHAR_MAX))
-    {
-      return encoding_type::ET_UTF8;
-    }
-  }
-  catch (int)
-  {
-    return encoding_type::ET_UNKNOWN;
-  }
-
-  return encoding_type::ET_UNKNOWN;
-}
-
 /* ------------------------------------------------ String Working ------------------------------------------------- */
 
 std::string vuapi lower_string_A(const std::string& string)
@@ -135,26 +55,30 @@ std::wstring vuapi upper_string_W(const std::wstring& string)
 std::string vuapi to_string_A(const std::wstring& string)
 {
   std::string s;
-  s.clear();
 
   if (string.empty())
   {
     return s;
   }
 
-  int N = (int)string.length() + 1;
+  // the ASCII strings are narrowed directly, the others are converted by the ANSI code page
 
-  std::unique_ptr<char[]> p(new char [N]);
-  if (p == nullptr)
+  s.resize(string.length());
+
+  if (narrow_ascii(string.data(), string.length(), &s[0]) == string.length())
   {
     return s;
   }
 
-  ZeroMemory(p.get(), N);
+  const int N = WideCharToMultiByte(
+    CP_ACP, WC_COMPOSITECHECK, string.data(), int(string.length()), NULL, 0, NULL, NULL);
 
-  WideCharToMultiByte(CP_ACP, WC_COMPOSITECHECK, string.c_str(), -1, p.get(), N, NULL, NULL);
+  s.resize(N > 0 ? N : 0);
 
-  s.assign(p.get());
+  if (N > 0)
+  {
+    WideCharToMultiByte(CP_ACP, WC_COMPOSITECHECK, string.data(), int(string.length()), &s[0], N, NULL, NULL);
+  }
 
   return s;
 }
@@ -162,57 +86,401 @@ std::string vuapi to_string_A(const std::wstring& string)
 std::wstring vuapi to_string_W(const std::string& string)
 {
   std::wstring s;
-  s.clear();
 
   if (string.empty())
   {
     return s;
   }
 
-  int N = (int)string.length() + 1;
+  // the ASCII strings are widened directly, the others are converted by the ANSI code page
 
-  std::unique_ptr<wchar[]> p(new wchar [N]);
-  if (p == nullptr)
+  s.resize(string.length());
+
+  if (widen_ascii(string.data(), string.length(), &s[0]) == string.length())
   {
-    s.clear();
+    return s;
   }
 
-  ZeroMemory(p.get(), 2*N);
+  const int N = MultiByteToWideChar(CP_ACP, 0, string.data(), int(string.length()), NULL, 0);
 
-  MultiByteToWideChar(CP_ACP, 0, string.c_str(), -1, p.get(), 2*N);
+  s.resize(N > 0 ? N : 0);
 
-  s.assign(p.get());
+  if (N > 0)
+  {
+    MultiByteToWideChar(CP_ACP, 0, string.data(), int(string.length()), &s[0], N);
+  }
 
   return s;
 }
 
-template <class std_string_t>
-std::vector<std_string_t> split_string_T(
-  const std_string_t& string, const std_string_t& separator, bool remove_empty)
+/**
+ * StringViewT
+ */
+
+template <typename T>
+const size_t StringViewT<T>::npos;
+
+template <typename T>
+StringViewT<T>::StringViewT() : m_ptr(nullptr), m_size(0)
 {
-  std::vector<std_string_t> l;
-  l.clear();
+}
+
+template <typename T>
+StringViewT<T>::StringViewT(const T* ptr)
+  : m_ptr(ptr), m_size(ptr != nullptr ? std::char_traits<T>::length(ptr) : 0)
+{
+}
+
+template <typename T>
+StringViewT<T>::StringViewT(const T* ptr, const size_t size) : m_ptr(ptr), m_size(size)
+{
+}
+
+template <typename T>
+StringViewT<T>::StringViewT(const TString& string) : m_ptr(string.data()), m_size(string.size())
+{
+}
+
+template <typename T>
+bool StringViewT<T>::operator==(const StringViewT& right) const
+{
+  return m_size == right.m_size && std::char_traits<T>::compare(m_ptr, right.m_ptr, m_size) == 0;
+}
+
+template <typename T>
+bool StringViewT<T>::operator!=(const StringViewT& right) const
+{
+  return !(*this == right);
+}
+
+template <typename T>
+const T& StringViewT<T>::operator[](const size_t index) const
+{
+  if (index >= m_size)
+  {
+    throw std::out_of_range(static_cast<const char*>("invalid index"));
+  }
+
+  return m_ptr[index];
+}
+
+template <typename T>
+const T* StringViewT<T>::data() const
+{
+  return m_ptr;
+}
+
+template <typename T>
+size_t StringViewT<T>::size() const
+{
+  return m_size;
+}
+
+template <typename T>
+bool StringViewT<T>::empty() const
+{
+  return m_size == 0;
+}
+
+template <typename T>
+const T* StringViewT<T>::begin() const
+{
+  return m_ptr;
+}
+
+template <typename T>
+const T* StringViewT<T>::end() const
+{
+  return m_ptr + m_size;
+}
+
+template <typename T>
+size_t StringViewT<T>::find(const T c, const size_t offset) const
+{
+  if (offset >= m_size)
+  {
+    return npos;
+  }
+
+  // memchr/wmemchr
+
+  const T* ptr = std::char_traits<T>::find(m_ptr + offset, m_size - offset, c);
+
+  return ptr != nullptr ? size_t(ptr - m_ptr) : npos;
+}
+
+/**
+ * The narrow strings are searched by the substring searching of the bytes, the wide strings are
+ * searched by their first characters then compared since a byte match could be misaligned.
+ */
+
+static size_t find_string(const char* ptr, const size_t size, const char* string, const size_t length)
+{
+  return find_bytes_first((const byte*)ptr, size, (const byte*)string, length);
+}
+
+static size_t find_string(const wchar* ptr, const size_t size, const wchar* string, const size_t length)
+{
+  typedef std::char_traits<wchar> traits;
+
+  for (size_t i = 0; size - i >= length;)
+  {
+    const wchar* p = traits::find(ptr + i, size - i - length + 1, string[0]);
+    if (p == nullptr)
+    {
+      break;
+    }
+
+    i = size_t(p - ptr);
+
+    if (traits::compare(p + 1, string + 1, length - 1) == 0)
+    {
+      return i;
+    }
+
+    i++;
+  }
+
+  return size_t(-1);
+}
+
+template <typename T>
+size_t StringViewT<T>::find(const StringViewT& string, const size_t offset) const
+{
+  if (offset > m_size || m_size - offset < string.m_size)
+  {
+    return npos;
+  }
 
   if (string.empty())
   {
-    return l;
+    return offset;
+  }
+
+  if (string.m_size == 1)
+  {
+    return this->find(string.m_ptr[0], offset);
+  }
+
+  const size_t result = find_string(m_ptr + offset, m_size - offset, string.m_ptr, string.m_size);
+
+  return result != size_t(-1) ? offset + result : npos;
+}
+
+template <typename T>
+size_t StringViewT<T>::find_first_of(const StringViewT& chars, const size_t offset) const
+{
+  for (size_t i = offset; i < m_size; i++)
+  {
+    if (std::char_traits<T>::find(chars.m_ptr, chars.m_size, m_ptr[i]) != nullptr)
+    {
+      return i;
+    }
+  }
+
+  return npos;
+}
+
+template <typename T>
+StringViewT<T> StringViewT<T>::substr(const size_t offset, const size_t count) const
+{
+  if (offset > m_size)
+  {
+    throw std::out_of_range(static_cast<const char*>("invalid offset"));
   }
 
-  std_string_t s(string), sep(separator), sub;
-  ulongptr start, end;
+  const size_t n = m_size - offset < count ? m_size - offset : count;
 
-  start = 0;
-  end = s.find(sep);
-  while (end != std_string_t::npos)
+  return StringViewT(m_ptr + offset, n);
+}
+
+template <typename T>
+typename StringViewT<T>::TString StringViewT<T>::to_string() const
+{
+  return m_size != 0 ? TString(m_ptr, m_size) : TString();
+}
+
+template class StringViewT<char>;
+template class StringViewT<wchar>;
+
+/**
+ * TokenizerT
+ */
+
+template <typename T>
+TokenizerT<T>::TokenizerT(const TStringView& text, const T separator, const bool remove_empty)
+  : m_text(text)
+  , m_separator()
+  , m_char(separator)
+  , m_single(true)
+  , m_remove_empty(remove_empty)
+  , m_type(separator_type::ST_STRING)
+{
+  memset(m_table, 0, sizeof(m_table));
+  this->reset();
+}
+
+template <typename T>
+TokenizerT<T>::TokenizerT(
+  const TStringView& text,
+  const TStringView& separator,
+  const bool remove_empty,
+  const separator_type type)
+  : m_text(text)
+  , m_separator(separator)
+  , m_char(0)
+  , m_single(false)
+  , m_remove_empty(remove_empty)
+  , m_type(type)
+{
+  memset(m_table, 0, sizeof(m_table));
+
+  // a separator of a single character is searched by memchr/wmemchr
+
+  if (separator.size() == 1)
+  {
+    m_single = true;
+    m_char = separator.data()[0];
+  }
+
+  if (type == separator_type::ST_ANY_OF)
+  {
+    for (auto c : separator)
+    {
+      const auto v = typename std::make_unsigned<T>::type(c);
+      if (v < 256)
+      {
+        m_table[v >> 5] |= 1U << (v & 31);
+      }
+    }
+  }
+
+  this->reset();
+}
+
+template <typename T>
+void TokenizerT<T>::reset()
+{
+  m_offset = 0;
+  m_done = m_text.empty();
+}
+
+template <typename T>
+size_t TokenizerT<T>::find_separator(const size_t offset, size_t& length) const
+{
+  if (m_single)
   {
-    sub = s.substr(start, end - start);
-    if (!sub.empty() || !remove_empty) l.push_back(std_string_t(sub.c_str()));
-    start = end + sep.length();
-    end = s.find(sep, start);
+    length = 1;
+    return m_text.find(m_char, offset);
   }
 
-  sub = s.substr(start, end);
-  if (!sub.empty() || !remove_empty) l.push_back(std_string_t(sub.c_str()));
+  // an empty separator never splits the text
+
+  if (m_separator.empty())
+  {
+    length = 0;
+    return TStringView::npos;
+  }
+
+  if (m_type == separator_type::ST_STRING)
+  {
+    length = m_separator.size();
+    return m_text.find(m_separator, offset);
+  }
+
+  length = 1;
+
+  const T* ptr = m_text.data();
+
+  for (size_t i = offset; i < m_text.size(); i++)
+  {
+    const auto v = typename std::make_unsigned<T>::type(ptr[i]);
+
+    if (v < 256 ? (m_table[v >> 5] & (1U << (v & 31))) != 0 :
+      std::char_traits<T>::find(m_separator.data(), m_separator.size(), ptr[i]) != nullptr)
+    {
+      return i;
+    }
+  }
+
+  return TStringView::npos;
+}
+
+template <typename T>
+bool TokenizerT<T>::next(TStringView& token)
+{
+  while (!m_done)
+  {
+    size_t length = 0;
+    const size_t end = this->find_separator(m_offset, length);
+
+    if (end == TStringView::npos)
+    {
+      token = m_text.substr(m_offset);
+      m_done = true;
+    }
+    else
+    {
+      token = m_text.substr(m_offset, end - m_offset);
+      m_offset = end + length;
+    }
+
+    if (!token.empty() || !m_remove_empty)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template class TokenizerT<char>;
+template class TokenizerT<wchar>;
+
+template <typename T>
+std::vector<StringViewT<T>> split_string_view_T(
+  const StringViewT<T>& string, const StringViewT<T>& separator, bool remove_empty)
+{
+  std::vector<StringViewT<T>> l;
+
+  TokenizerT<T> tokenizer(string, separator, remove_empty);
+
+  StringViewT<T> token;
+  while (tokenizer.next(token))
+  {
+    l.push_back(token);
+  }
+
+  return l;
+}
+
+std::vector<StringViewA> vuapi split_string_view_A(
+  const StringViewA& string, const StringViewA& separator, bool remove_empty)
+{
+  return split_string_view_T<char>(string, separator, remove_empty);
+}
+
+std::vector<StringViewW> vuapi split_string_view_W(
+  const StringViewW& string, const StringViewW& separator, bool remove_empty)
+{
+  return split_string_view_T<wchar>(string, separator, remove_empty);
+}
+
+template <class std_string_t>
+std::vector<std_string_t> split_string_T(
+  const std_string_t& string, const std_string_t& separator, bool remove_empty)
+{
+  typedef typename std_string_t::value_type char_t;
+
+  std::vector<std_string_t> l;
+
+  TokenizerT<char_t> tokenizer(string, separator, remove_empty);
+
+  StringViewT<char_t> token;
+  while (tokenizer.next(token))
+  {
+    l.push_back(token.to_string());
+  }
 
   return l;
 }
@@ -477,9 +745,7 @@ bool vuapi starts_with_A(const std::string& text, const std::string& with, bool
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_A(text);
-    const auto v2 = lower_string_A(with);
-    return starts_with_T<std::string>(v1, v2);
+    return text.length() >= with.length() && equal_ignore_case_A(text.data(), with.data(), with.length());
   }
 
   return starts_with_T<std::string>(text, with);
@@ -489,9 +755,7 @@ bool vuapi starts_with_W(const std::wstring& text, const std::wstring& with, boo
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_W(text);
-    const auto v2 = lower_string_W(with);
-    return starts_with_T<std::wstring>(v1, v2);
+    return text.length() >= with.length() && equal_ignore_case_W(text.data(), with.data(), with.length());
   }
 
   return starts_with_T<std::wstring>(text, with);
@@ -508,9 +772,8 @@ bool vuapi ends_with_A(const std::string& text, const std::string& with, bool ig
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_A(text);
-    const auto v2 = lower_string_A(with);
-    return ends_with_T<std::string>(v1, v2);
+    return text.length() >= with.length() &&
+      equal_ignore_case_A(text.data() + text.length() - with.length(), with.data(), with.length());
   }
 
   return ends_with_T<std::string>(text, with);
@@ -520,9 +783,8 @@ bool vuapi ends_with_W(const std::wstring& text, const std::wstring& with, bool
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_W(text);
-    const auto v2 = lower_string_W(with);
-    return ends_with_T<std::wstring>(v1, v2);
+    return text.length() >= with.length() &&
+      equal_ignore_case_W(text.data() + text.length() - with.length(), with.data(), with.length());
   }
 
   return ends_with_T<std::wstring>(text, with);
@@ -532,9 +794,7 @@ bool vuapi contains_string_A(const std::string& text, const std::string& test, b
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_A(text);
-    const auto v2 = lower_string_A(test);
-    return v1.find(v2) != std::string::npos;
+    return find_ignore_case_A(text.data(), text.length(), test.data(), test.length()) != -1;
   }
 
   return text.find(test) != std::string::npos;
@@ -544,9 +804,7 @@ bool vuapi contains_string_W(const std::wstring& text, const std::wstring& test,
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_W(text);
-    const auto v2 = lower_string_W(test);
-    return v1.find(v2) != std::string::npos;
+    return find_ignore_case_W(text.data(), text.length(), test.data(), test.length()) != -1;
   }
 
   return text.find(test) != std::wstring::npos;
@@ -556,9 +814,7 @@ bool vuapi compare_string_A(const std::string& vl, const std::string& vr, bool i
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_A(vl);
-    const auto v2 = lower_string_A(vr);
-    return v1 == v2;
+    return vl.length() == vr.length() && equal_ignore_case_A(vl.data(), vr.data(), vl.length());
   }
 
   return vl == vr;
@@ -568,9 +824,7 @@ bool vuapi compare_string_W(const std::wstring& vl, const std::wstring& vr, bool
 {
   if (ignore_case)
   {
-    const auto v1 = lower_string_W(vl);
-    const auto v2 = lower_string_W(vr);
-    return v1 == v2;
+    return vl.length() == vr.length() && equal_ignore_case_W(vl.data(), vr.data(), vl.length());
   }
 
   return vl == vr;
@@ -0,0 +1,313 @@
+/**
+ * @file   url.cpp
+ * @author Vic P.
+ * @brief  Implementation for URL Encoding
+ */
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+/**
+ * The classes of the bytes, the unreserved characters of RFC 3986 are kept as is and the others are
+ * escaped, the hex digits keep their values in the low nibble.
+ */
+
+static const byte URL_HEX_DIGIT  = 0x10;
+static const byte URL_UNRESERVED = 0x20;
+
+static const char URL_HEX_DIGITS[] = "0123456789ABCDEF";
+
+struct URLTable
+{
+  byte classes[256];
+
+  URLTable()
+  {
+    memset(classes, 0, sizeof(classes));
+
+    for (int i = 0; i < 10; i++)
+    {
+      classes['0' + i] = URL_UNRESERVED | URL_HEX_DIGIT | byte(i);
+    }
+
+    for (int i = 0; i < 26; i++)
+    {
+      classes['a' + i] = URL_UNRESERVED;
+      classes['A' + i] = URL_UNRESERVED;
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+      classes['a' + i] |= URL_HEX_DIGIT | byte(10 + i);
+      classes['A' + i] |= URL_HEX_DIGIT | byte(10 + i);
+    }
+
+    for (auto c : "-_.~")
+    {
+      if (c != '\0') classes[byte(c)] = URL_UNRESERVED;
+    }
+  }
+};
+
+static const URLTable g_url_table;
+
+/**
+ * Encoding
+ * The bytes are encoded as is, so the text of UTF-8 is escaped by its UTF-8 sequences.
+ */
+
+static size_t url_encoded_length(const byte* ptr, const size_t size, const bool form)
+{
+  size_t n = size;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    if ((g_url_table.classes[ptr[i]] & URL_UNRESERVED) == 0 && !(form && ptr[i] == ' '))
+    {
+      n += 2;
+    }
+  }
+
+  return n;
+}
+
+template <typename T>
+static void url_encode_bytes(const byte* ptr, const size_t size, T* buffer, const bool form)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    const byte c = ptr[i];
+
+    if ((g_url_table.classes[c] & URL_UNRESERVED) != 0)
+    {
+      *buffer++ = T(c);
+    }
+    else if (form && c == ' ')
+    {
+      *buffer++ = T('+');
+    }
+    else
+    {
+      *buffer++ = T('%');
+      *buffer++ = T(URL_HEX_DIGITS[c >> 4]);
+      *buffer++ = T(URL_HEX_DIGITS[c & 0x0F]);
+    }
+  }
+}
+
+/**
+ * Decoding
+ * The decoded text is never longer than the encoded text and each byte is written at or before the byte
+ * that is read, so the text can be decoded in place. The malformed escapes are kept as is.
+ */
+
+static size_t url_decode_bytes(const byte* text, const size_t length, byte* buffer, const bool form)
+{
+  size_t n = 0;
+
+  for (size_t i = 0; i < length; i++)
+  {
+    byte c = text[i];
+
+    if (c == '%')
+    {
+      if (length - i > 2)
+      {
+        const byte high = g_url_table.classes[text[i + 1]];
+        const byte low  = g_url_table.classes[text[i + 2]];
+        if ((high & low & URL_HEX_DIGIT) != 0)
+        {
+          c = byte(((high & 0x0F) << 4) | (low & 0x0F));
+          i += 2;
+        }
+      }
+    }
+    else if (form && c == '+')
+    {
+      c = ' ';
+    }
+
+    buffer[n++] = c;
+  }
+
+  return n;
+}
+
+/**
+ * The wide texts are escaped by their UTF-8 sequences, the texts that are not well-formed UTF-16 or UTF-8
+ * fall back to the ANSI code page.
+ */
+
+static std::string url_to_bytes(const std::wstring& text)
+{
+  std::string result;
+  if (!utf16_to_utf8(text, result))
+  {
+    result = to_string_A(text);
+  }
+
+  return result;
+}
+
+static std::wstring url_from_bytes(const std::string& bytes)
+{
+  std::wstring result;
+  if (!utf8_to_utf16(bytes, result))
+  {
+    result = to_string_W(bytes);
+  }
+
+  return result;
+}
+
+size_t vuapi url_encode_A(
+  const char* text, const size_t length, char* buffer, const size_t size, const bool form)
+{
+  if (text == nullptr && length != 0)
+  {
+    return 0;
+  }
+
+  const auto ptr = reinterpret_cast<const byte*>(text);
+
+  const size_t n = url_encoded_length(ptr, length, form);
+  if (buffer != nullptr && n <= size)
+  {
+    url_encode_bytes(ptr, length, buffer, form);
+  }
+
+  return n;
+}
+
+void vuapi url_encode_A(const std::string& text, std::string& result, const bool form)
+{
+  const auto ptr = reinterpret_cast<const byte*>(text.data());
+
+  std::string encoded(url_encoded_length(ptr, text.size(), form), '\0');
+  if (!encoded.empty())
+  {
+    url_encode_bytes(ptr, text.size(), &encoded[0], form);
+  }
+
+  result.swap(encoded);
+}
+
+void vuapi url_encode_W(const std::wstring& text, std::wstring& result, const bool form)
+{
+  const auto bytes = url_to_bytes(text);
+  const auto ptr = reinterpret_cast<const byte*>(bytes.data());
+
+  std::wstring encoded(url_encoded_length(ptr, bytes.size(), form), L'\0');
+  if (!encoded.empty())
+  {
+    url_encode_bytes(ptr, bytes.size(), &encoded[0], form);
+  }
+
+  result.swap(encoded);
+}
+
+size_t vuapi url_decode_A(char* text, const size_t length, const bool form)
+{
+  if (text == nullptr)
+  {
+    return 0;
+  }
+
+  const auto ptr = reinterpret_cast<byte*>(text);
+  return url_decode_bytes(ptr, length, ptr, form);
+}
+
+void vuapi url_decode_A(const std::string& text, std::string& result, const bool form)
+{
+  std::string decoded(text);
+  if (!decoded.empty())
+  {
+    decoded.resize(url_decode_A(&decoded[0], decoded.size(), form));
+  }
+
+  result.swap(decoded);
+}
+
+void vuapi url_decode_W(const std::wstring& text, std::wstring& result, const bool form)
+{
+  std::string bytes;
+  url_decode_A(url_to_bytes(text), bytes, form);
+  result = url_from_bytes(bytes);
+}
+
+/**
+ * Query String
+ * The parameters are separated by '&' and their keys and values by the first '='. A leading '?' and
+ * the fragment are skipped, the empty parameters are dropped.
+ */
+
+template <typename T>
+static void parse_query_string_T(
+  const StringViewT<T>& query, std::vector<std::pair<StringViewT<T>, StringViewT<T>>>& params)
+{
+  typedef StringViewT<T> TStringView;
+
+  params.clear();
+
+  TStringView text = query;
+
+  if (!text.empty() && text[0] == T('?'))
+  {
+    text = text.substr(1);
+  }
+
+  const size_t fragment = text.find(T('#'));
+  if (fragment != TStringView::npos)
+  {
+    text = text.substr(0, fragment);
+  }
+
+  TokenizerT<T> tokenizer(text, T('&'), true);
+
+  TStringView token;
+  while (tokenizer.next(token))
+  {
+    const size_t separator = token.find(T('='));
+    if (separator == TStringView::npos)
+    {
+      params.push_back(std::make_pair(token, TStringView(token.end(), 0)));
+    }
+    else
+    {
+      params.push_back(std::make_pair(token.substr(0, separator), token.substr(separator + 1)));
+    }
+  }
+}
+
+void vuapi parse_query_string_A(const StringViewA& query, std::vector<QueryParamA>& params)
+{
+  parse_query_string_T(query, params);
+}
+
+void vuapi parse_query_string_W(const StringViewW& query, std::vector<QueryParamW>& params)
+{
+  parse_query_string_T(query, params);
+}
+
+void vuapi parse_query_string_A(char* query, const size_t length, std::vector<QueryParamA>& params)
+{
+  parse_query_string_T(StringViewA(query, length), params);
+
+  // the views point into the query, so each of them is decoded in its own place
+
+  const auto decode = [&](StringViewA& view) -> void
+  {
+    const auto ptr = query + (view.data() - query);
+    view = StringViewA(ptr, url_decode_A(ptr, view.size(), true));
+  };
+
+  for (auto& param : params)
+  {
+    decode(param.first);
+    decode(param.second);
+  }
+}
+
+} // namespace vu
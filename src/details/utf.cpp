@@ -0,0 +1,820 @@
+/**
+ * @file   utf.cpp
+ * @author Vic P.
+ * @brief  Implementation for Unicode Transcoding
+ */
+
+#include "utf.h"
+#include "simd.h"
+
+namespace vu
+{
+
+static_assert(sizeof(wchar) == sizeof(uint16), "UTF-16 requires 16-bit wide characters");
+
+/**
+ * ASCII
+ * The runs of the ASCII characters are converted by SIMD blocks, the rest of a run is converted one by one.
+ */
+
+static size_t widen_ascii_scalar(const byte* ptr, const size_t size, uint16* buffer)
+{
+  size_t i = 0;
+
+  for (; i < size && ptr[i] < 0x80; i++)
+  {
+    if (buffer != nullptr) buffer[i] = ptr[i];
+  }
+
+  return i;
+}
+
+static size_t narrow_ascii_scalar(const uint16* ptr, const size_t size, byte* buffer)
+{
+  size_t i = 0;
+
+  for (; i < size && ptr[i] < 0x80; i++)
+  {
+    if (buffer != nullptr) buffer[i] = byte(ptr[i]);
+  }
+
+  return i;
+}
+
+#ifdef VU_SIMD_X86
+
+/**
+ * SSE2
+ */
+
+VU_TARGET_SSE2 static size_t widen_ascii_sse2(const byte* ptr, const size_t size, uint16* buffer)
+{
+  const auto zero = _mm_setzero_si128();
+
+  size_t i = 0;
+
+  for (; i + 16 <= size; i += 16)
+  {
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+    if (_mm_movemask_epi8(v) != 0)
+    {
+      break;
+    }
+
+    if (buffer != nullptr)
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+  }
+
+  return i + widen_ascii_scalar(ptr + i, size - i, buffer != nullptr ? buffer + i : nullptr);
+}
+
+VU_TARGET_SSE2 static size_t narrow_ascii_sse2(const uint16* ptr, const size_t size, byte* buffer)
+{
+  const auto mask = _mm_set1_epi16(short(0xFF80));
+  const auto zero = _mm_setzero_si128();
+
+  size_t i = 0;
+
+  for (; i + 16 <= size; i += 16)
+  {
+    const auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i));
+    const auto v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i + 8));
+    const auto non_ascii = _mm_and_si128(_mm_or_si128(v1, v2), mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF)
+    {
+      break;
+    }
+
+    if (buffer != nullptr)
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + i), _mm_packus_epi16(v1, v2));
+    }
+  }
+
+  return i + narrow_ascii_scalar(ptr + i, size - i, buffer != nullptr ? buffer + i : nullptr);
+}
+
+/**
+ * AVX2
+ */
+
+VU_TARGET_AVX2 static size_t widen_ascii_avx2(const byte* ptr, const size_t size, uint16* buffer)
+{
+  size_t i = 0;
+
+  for (; i + 32 <= size; i += 32)
+  {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i));
+    if (_mm256_movemask_epi8(v) != 0)
+    {
+      break;
+    }
+
+    if (buffer != nullptr)
+    {
+      const auto lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v));
+      const auto hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + i), lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + i + 16), hi);
+    }
+  }
+
+  return i + widen_ascii_sse2(ptr + i, size - i, buffer != nullptr ? buffer + i : nullptr);
+}
+
+VU_TARGET_AVX2 static size_t narrow_ascii_avx2(const uint16* ptr, const size_t size, byte* buffer)
+{
+  const auto mask = _mm256_set1_epi16(short(0xFF80));
+
+  size_t i = 0;
+
+  for (; i + 32 <= size; i += 32)
+  {
+    const auto v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i));
+    const auto v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i + 16));
+    const auto non_ascii = _mm256_and_si256(_mm256_or_si256(v1, v2), mask);
+    if (!_mm256_testz_si256(non_ascii, non_ascii))
+    {
+      break;
+    }
+
+    if (buffer != nullptr)
+    {
+      const auto v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v1, v2), 0xD8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + i), v);
+    }
+  }
+
+  return i + narrow_ascii_sse2(ptr + i, size - i, buffer != nullptr ? buffer + i : nullptr);
+}
+
+#endif // VU_SIMD_X86
+
+/**
+ * Dispatcher
+ */
+
+typedef size_t (*fn_widen_ascii_t)(const byte* ptr, const size_t size, uint16* buffer);
+typedef size_t (*fn_narrow_ascii_t)(const uint16* ptr, const size_t size, byte* buffer);
+
+static fn_widen_ascii_t select_widen_ascii_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return widen_ascii_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return widen_ascii_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return widen_ascii_scalar;
+}
+
+static fn_narrow_ascii_t select_narrow_ascii_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return narrow_ascii_avx2;
+  }
+
+  if (features.sse2)
+  {
+    return narrow_ascii_sse2;
+  }
+  #endif // VU_SIMD_X86
+
+  return narrow_ascii_scalar;
+}
+
+static size_t widen_ascii(const byte* ptr, const size_t size, uint16* buffer)
+{
+  static const fn_widen_ascii_t fn = select_widen_ascii_kernel();
+  return fn(ptr, size, buffer);
+}
+
+static size_t narrow_ascii(const uint16* ptr, const size_t size, byte* buffer)
+{
+  static const fn_narrow_ascii_t fn = select_narrow_ascii_kernel();
+  return fn(ptr, size, buffer);
+}
+
+size_t widen_ascii(const char* text, const size_t length, wchar* buffer)
+{
+  return widen_ascii(
+    reinterpret_cast<const byte*>(text), length, reinterpret_cast<uint16*>(buffer));
+}
+
+size_t narrow_ascii(const wchar* text, const size_t length, char* buffer)
+{
+  return narrow_ascii(
+    reinterpret_cast<const uint16*>(text), length, reinterpret_cast<byte*>(buffer));
+}
+
+/**
+ * Code Points
+ * The decoders reject the truncated, overlong and surrogate sequences, the unpaired surrogates
+ * and the code points above U+10FFFF.
+ */
+
+static const uint32 MAX_CODE_POINT = 0x10FFFF;
+
+static inline bool is_surrogate(const uint32 cp)
+{
+  return cp >= 0xD800 && cp <= 0xDFFF;
+}
+
+static inline bool decode(const byte* ptr, const size_t size, size_t& i, uint32& cp)
+{
+  const byte c = ptr[i];
+
+  size_t n = 0;
+  uint32 min = 0;
+
+  if (c < 0x80)
+  {
+    cp = c;
+    i += 1;
+    return true;
+  }
+  else if ((c & 0xE0) == 0xC0)
+  {
+    n = 2, cp = c & 0x1F, min = 0x80;
+  }
+  else if ((c & 0xF0) == 0xE0)
+  {
+    n = 3, cp = c & 0x0F, min = 0x800;
+  }
+  else if ((c & 0xF8) == 0xF0)
+  {
+    n = 4, cp = c & 0x07, min = 0x10000;
+  }
+  else
+  {
+    return false;
+  }
+
+  if (size - i < n)
+  {
+    return false;
+  }
+
+  for (size_t j = 1; j < n; j++)
+  {
+    const byte t = ptr[i + j];
+    if ((t & 0xC0) != 0x80)
+    {
+      return false;
+    }
+
+    cp = (cp << 6) | (t & 0x3F);
+  }
+
+  if (cp < min || cp > MAX_CODE_POINT || is_surrogate(cp))
+  {
+    return false;
+  }
+
+  i += n;
+
+  return true;
+}
+
+static inline bool decode(const uint16* ptr, const size_t size, size_t& i, uint32& cp)
+{
+  const uint32 u = ptr[i];
+
+  if (!is_surrogate(u))
+  {
+    cp = u;
+    i += 1;
+    return true;
+  }
+
+  if (u > 0xDBFF || size - i < 2 || ptr[i + 1] < 0xDC00 || ptr[i + 1] > 0xDFFF)
+  {
+    return false;
+  }
+
+  cp = 0x10000 + ((u - 0xD800) << 10) + (ptr[i + 1] - 0xDC00);
+  i += 2;
+
+  return true;
+}
+
+static inline bool decode(const uint32* ptr, const size_t size, size_t& i, uint32& cp)
+{
+  cp = ptr[i++];
+  return cp <= MAX_CODE_POINT && !is_surrogate(cp);
+}
+
+/**
+ * The output of the encoders, the units are counted but not written if they exceed the buffer.
+ */
+
+template <typename T>
+struct Output
+{
+  T* buffer;
+  size_t size;
+  size_t n;
+
+  Output(T* buffer, const size_t size) : buffer(buffer), size(size), n(0) {}
+
+  void put(const uint32 unit)
+  {
+    if (buffer != nullptr && n < size) buffer[n] = T(unit);
+    n++;
+  }
+
+  size_t left() const
+  {
+    return buffer != nullptr && n < size ? size - n : 0;
+  }
+};
+
+static inline void encode(Output<byte>& output, const uint32 cp)
+{
+  if (cp < 0x80)
+  {
+    output.put(cp);
+  }
+  else if (cp < 0x800)
+  {
+    output.put(0xC0 | (cp >> 6));
+    output.put(0x80 | (cp & 0x3F));
+  }
+  else if (cp < 0x10000)
+  {
+    output.put(0xE0 | (cp >> 12));
+    output.put(0x80 | ((cp >> 6) & 0x3F));
+    output.put(0x80 | (cp & 0x3F));
+  }
+  else
+  {
+    output.put(0xF0 | (cp >> 18));
+    output.put(0x80 | ((cp >> 12) & 0x3F));
+    output.put(0x80 | ((cp >> 6) & 0x3F));
+    output.put(0x80 | (cp & 0x3F));
+  }
+}
+
+static inline void encode(Output<uint16>& output, const uint32 cp)
+{
+  if (cp < 0x10000)
+  {
+    output.put(cp);
+  }
+  else
+  {
+    output.put(0xD800 + ((cp - 0x10000) >> 10));
+    output.put(0xDC00 + ((cp - 0x10000) & 0x3FF));
+  }
+}
+
+static inline void encode(Output<uint32>& output, const uint32 cp)
+{
+  output.put(cp);
+}
+
+/**
+ * The ASCII runs between UTF-8 and UTF-16 use the SIMD kernels, the others are copied one by one.
+ */
+
+template <typename S, typename D>
+static inline size_t copy_ascii(const S* ptr, const size_t size, Output<D>& output)
+{
+  size_t i = 0;
+
+  for (; i < size && ptr[i] < 0x80; i++)
+  {
+    output.put(ptr[i]);
+  }
+
+  return i;
+}
+
+static inline size_t copy_ascii(const byte* ptr, const size_t size, Output<uint16>& output)
+{
+  const size_t n_fit = size < output.left() ? size : output.left();
+
+  size_t n = widen_ascii(ptr, n_fit, n_fit != 0 ? output.buffer + output.n : nullptr);
+  if (n == n_fit && n < size)
+  {
+    n += widen_ascii(ptr + n, size - n, nullptr); // the rest of the run is only counted
+  }
+
+  output.n += n;
+
+  return n;
+}
+
+static inline size_t copy_ascii(const uint16* ptr, const size_t size, Output<byte>& output)
+{
+  const size_t n_fit = size < output.left() ? size : output.left();
+
+  size_t n = narrow_ascii(ptr, n_fit, n_fit != 0 ? output.buffer + output.n : nullptr);
+  if (n == n_fit && n < size)
+  {
+    n += narrow_ascii(ptr + n, size - n, nullptr); // the rest of the run is only counted
+  }
+
+  output.n += n;
+
+  return n;
+}
+
+template <typename S, typename D>
+static size_t transcode(const S* text, const size_t length, D* buffer, const size_t size)
+{
+  if (text == nullptr && length != 0)
+  {
+    return -1;
+  }
+
+  Output<D> output(buffer, size);
+
+  for (size_t i = 0; i < length;)
+  {
+    if (text[i] < 0x80)
+    {
+      i += copy_ascii(text + i, length - i, output);
+      continue;
+    }
+
+    uint32 cp = 0;
+    if (!decode(text, length, i, cp))
+    {
+      return -1;
+    }
+
+    encode(output, cp);
+  }
+
+  return output.n;
+}
+
+size_t vuapi utf8_to_utf16(const char* text, const size_t length, wchar* buffer, const size_t size)
+{
+  return transcode(
+    reinterpret_cast<const byte*>(text), length, reinterpret_cast<uint16*>(buffer), size);
+}
+
+size_t vuapi utf16_to_utf8(const wchar* text, const size_t length, char* buffer, const size_t size)
+{
+  return transcode(
+    reinterpret_cast<const uint16*>(text), length, reinterpret_cast<byte*>(buffer), size);
+}
+
+size_t vuapi utf8_to_utf32(const char* text, const size_t length, uint32* buffer, const size_t size)
+{
+  return transcode(reinterpret_cast<const byte*>(text), length, buffer, size);
+}
+
+size_t vuapi utf32_to_utf8(const uint32* text, const size_t length, char* buffer, const size_t size)
+{
+  return transcode(text, length, reinterpret_cast<byte*>(buffer), size);
+}
+
+size_t vuapi utf16_to_utf32(const wchar* text, const size_t length, uint32* buffer, const size_t size)
+{
+  return transcode(reinterpret_cast<const uint16*>(text), length, buffer, size);
+}
+
+size_t vuapi utf32_to_utf16(const uint32* text, const size_t length, wchar* buffer, const size_t size)
+{
+  return transcode(text, length, reinterpret_cast<uint16*>(buffer), size);
+}
+
+bool vuapi utf8_to_utf16(const std::string& text, std::wstring& result)
+{
+  result.clear();
+
+  const size_t n = utf8_to_utf16(text.data(), text.size(), nullptr, 0);
+  if (n == -1)
+  {
+    return false;
+  }
+
+  if (n != 0)
+  {
+    result.resize(n);
+    utf8_to_utf16(text.data(), text.size(), &result[0], n);
+  }
+
+  return true;
+}
+
+bool vuapi utf16_to_utf8(const std::wstring& text, std::string& result)
+{
+  result.clear();
+
+  const size_t n = utf16_to_utf8(text.data(), text.size(), nullptr, 0);
+  if (n == -1)
+  {
+    return false;
+  }
+
+  if (n != 0)
+  {
+    result.resize(n);
+    utf16_to_utf8(text.data(), text.size(), &result[0], n);
+  }
+
+  return true;
+}
+
+/**
+ * Validation
+ * The SIMD validators check the blocks by the lookup tables of the byte nibbles (Keiser & Lemire,
+ * "Validating UTF-8 In Less Than One Instruction Per Byte"). Each byte and its previous byte select
+ * the error bits of their nibbles, the bits are only left if all three lookups agree on an error,
+ * the continuations of the three and four byte sequences are checked by the saturated subtractions
+ * of the lead bytes. The pure ASCII blocks are skipped by a movemask.
+ */
+
+static bool validate_utf8_scalar(const byte* ptr, const size_t size)
+{
+  for (size_t i = 0; i < size;)
+  {
+    uint32 cp = 0;
+    if (!decode(ptr, size, i, cp))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#ifdef VU_SIMD_X86
+
+// the error bits of the lookup tables
+
+static const char TOO_SHORT      = 1 << 0; // a lead byte is not followed by a continuation byte
+static const char TOO_LONG       = 1 << 1; // an ASCII byte is followed by a continuation byte
+static const char OVERLONG_3     = 1 << 2;
+static const char TOO_LARGE      = 1 << 3;
+static const char SURROGATE      = 1 << 4;
+static const char OVERLONG_2     = 1 << 5;
+static const char TOO_LARGE_1000 = 1 << 6;
+static const char OVERLONG_4     = 1 << 6;
+static const char TWO_CONTS      = char(1 << 7); // two continuation bytes, maybe a part of a sequence
+static const char CARRY          = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+#define VU_UTF8_BYTE_1_HIGH \
+  TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, \
+  TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, \
+  TOO_SHORT | OVERLONG_2, \
+  TOO_SHORT, \
+  TOO_SHORT | OVERLONG_3 | SURROGATE, \
+  TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+
+#define VU_UTF8_BYTE_1_LOW \
+  CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, \
+  CARRY | OVERLONG_2, \
+  CARRY, \
+  CARRY, \
+  CARRY | TOO_LARGE, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000
+
+#define VU_UTF8_BYTE_2_HIGH \
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE, \
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+
+/**
+ * SSSE3
+ */
+
+struct UTF8CheckerSSSE3
+{
+  __m128i error;
+  __m128i prev_input;
+  __m128i prev_incomplete;
+
+  VU_TARGET_SSSE3 UTF8CheckerSSSE3()
+  {
+    error = _mm_setzero_si128();
+    prev_input = _mm_setzero_si128();
+    prev_incomplete = _mm_setzero_si128();
+  }
+
+  VU_TARGET_SSSE3 static inline __m128i high_nibbles(const __m128i v)
+  {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+  }
+
+  VU_TARGET_SSSE3 inline void check(const __m128i input)
+  {
+    if (_mm_movemask_epi8(input) == 0)
+    {
+      error = _mm_or_si128(error, prev_incomplete);
+      prev_incomplete = _mm_setzero_si128();
+    }
+    else
+    {
+      const auto prev1 = _mm_alignr_epi8(input, prev_input, 15);
+      const auto prev2 = _mm_alignr_epi8(input, prev_input, 14);
+      const auto prev3 = _mm_alignr_epi8(input, prev_input, 13);
+
+      const auto byte_1_high = _mm_shuffle_epi8(_mm_setr_epi8(VU_UTF8_BYTE_1_HIGH), high_nibbles(prev1));
+      const auto byte_1_low  = _mm_shuffle_epi8(
+        _mm_setr_epi8(VU_UTF8_BYTE_1_LOW), _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+      const auto byte_2_high = _mm_shuffle_epi8(_mm_setr_epi8(VU_UTF8_BYTE_2_HIGH), high_nibbles(input));
+      const auto special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+      const auto third  = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xE0 - 0x80)));
+      const auto fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xF0 - 0x80)));
+      const auto must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+
+      error = _mm_or_si128(error, _mm_xor_si128(must23, special));
+
+      // the lead bytes at the end of the block that need more bytes than left in the block
+
+      const auto max = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+      prev_incomplete = _mm_subs_epu8(input, max);
+    }
+
+    prev_input = input;
+  }
+
+  VU_TARGET_SSSE3 inline bool failed() const
+  {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF;
+  }
+};
+
+VU_TARGET_SSSE3 static bool validate_utf8_ssse3(const byte* ptr, const size_t size)
+{
+  UTF8CheckerSSSE3 checker;
+
+  size_t i = 0;
+
+  for (; i + 16 <= size; i += 16)
+  {
+    checker.check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i)));
+  }
+
+  // the tail is padded by the null bytes, so a truncated sequence at the end is reported as too short
+
+  byte tail[16] = { 0 };
+  if (i < size)
+  {
+    memcpy(tail, ptr + i, size - i);
+  }
+  checker.check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)));
+
+  return !checker.failed();
+}
+
+/**
+ * AVX2
+ */
+
+struct UTF8CheckerAVX2
+{
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+
+  VU_TARGET_AVX2 UTF8CheckerAVX2()
+  {
+    error = _mm256_setzero_si256();
+    prev_input = _mm256_setzero_si256();
+    prev_incomplete = _mm256_setzero_si256();
+  }
+
+  VU_TARGET_AVX2 static inline __m256i high_nibbles(const __m256i v)
+  {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+  }
+
+  VU_TARGET_AVX2 static inline __m256i table(const __m128i v)
+  {
+    return _mm256_broadcastsi128_si256(v);
+  }
+
+  VU_TARGET_AVX2 inline void check(const __m256i input)
+  {
+    if (_mm256_movemask_epi8(input) == 0)
+    {
+      error = _mm256_or_si256(error, prev_incomplete);
+      prev_incomplete = _mm256_setzero_si256();
+    }
+    else
+    {
+      // the high lane of the previous block and the low lane of this block, to shift across the lanes
+
+      const auto shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+      const auto prev1 = _mm256_alignr_epi8(input, shifted, 15);
+      const auto prev2 = _mm256_alignr_epi8(input, shifted, 14);
+      const auto prev3 = _mm256_alignr_epi8(input, shifted, 13);
+
+      const auto byte_1_high = _mm256_shuffle_epi8(table(_mm_setr_epi8(VU_UTF8_BYTE_1_HIGH)), high_nibbles(prev1));
+      const auto byte_1_low  = _mm256_shuffle_epi8(
+        table(_mm_setr_epi8(VU_UTF8_BYTE_1_LOW)), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+      const auto byte_2_high = _mm256_shuffle_epi8(table(_mm_setr_epi8(VU_UTF8_BYTE_2_HIGH)), high_nibbles(input));
+      const auto special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+      const auto third  = _mm256_subs_epu8(prev2, _mm256_set1_epi8(char(0xE0 - 0x80)));
+      const auto fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(char(0xF0 - 0x80)));
+      const auto must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(char(0x80)));
+
+      error = _mm256_or_si256(error, _mm256_xor_si256(must23, special));
+
+      const auto max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xF0 - 1), char(0xE0 - 1), char(0xC0 - 1));
+      prev_incomplete = _mm256_subs_epu8(input, max);
+    }
+
+    prev_input = input;
+  }
+
+  VU_TARGET_AVX2 inline bool failed() const
+  {
+    return !_mm256_testz_si256(error, error);
+  }
+};
+
+VU_TARGET_AVX2 static bool validate_utf8_avx2(const byte* ptr, const size_t size)
+{
+  UTF8CheckerAVX2 checker;
+
+  size_t i = 0;
+
+  for (; i + 32 <= size; i += 32)
+  {
+    checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + i)));
+  }
+
+  byte tail[32] = { 0 };
+  if (i < size)
+  {
+    memcpy(tail, ptr + i, size - i);
+  }
+  checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail)));
+
+  return !checker.failed();
+}
+
+#undef VU_UTF8_BYTE_1_HIGH
+#undef VU_UTF8_BYTE_1_LOW
+#undef VU_UTF8_BYTE_2_HIGH
+
+#endif // VU_SIMD_X86
+
+typedef bool (*fn_validate_utf8_t)(const byte* ptr, const size_t size);
+
+static fn_validate_utf8_t select_validate_utf8_kernel()
+{
+  #ifdef VU_SIMD_X86
+  const auto& features = CPUFeatures::instance();
+
+  if (features.avx2)
+  {
+    return validate_utf8_avx2;
+  }
+
+  if (features.ssse3)
+  {
+    return validate_utf8_ssse3;
+  }
+  #endif // VU_SIMD_X86
+
+  return validate_utf8_scalar;
+}
+
+bool validate_utf8(const char* text, const size_t length)
+{
+  static const fn_validate_utf8_t fn = select_validate_utf8_kernel();
+  return fn(reinterpret_cast<const byte*>(text), length);
+}
+
+} // namespace vu
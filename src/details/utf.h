@@ -0,0 +1,27 @@
+/**
+ * @file   utf.h
+ * @author Vic P.
+ * @brief  Header for Unicode Transcoding
+ */
+
+#pragma once
+
+#include "Vutils.h"
+
+namespace vu
+{
+
+/**
+ * Convert the leading ASCII characters of a text, the conversion stops at the first non-ASCII character.
+ * @param buffer The buffer for at least `length` characters, or null to only count them.
+ * @return The number of the converted characters.
+ */
+size_t widen_ascii(const char* text, const size_t length, wchar* buffer);
+size_t narrow_ascii(const wchar* text, const size_t length, char* buffer);
+
+/**
+ * Check the text is well-formed UTF-8, a truncated sequence at the end is invalid.
+ */
+bool validate_utf8(const char* text, const size_t length);
+
+} // namespace vu